@@ -0,0 +1,63 @@
+#include "AllocationCount.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic< uint64_t > allocations(0);
+
+uint64_t allocation_count() {
+	return allocations.load(std::memory_order_relaxed);
+}
+
+//every new below comes through here, and every delete frees with std::free():
+static void *counted_malloc(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size) {
+	void *ret = counted_malloc(size);
+	if (!ret) throw std::bad_alloc();
+	return ret;
+}
+
+void *operator new[](std::size_t size) {
+	void *ret = counted_malloc(size);
+	if (!ret) throw std::bad_alloc();
+	return ret;
+}
+
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept {
+	return counted_malloc(size);
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+	return counted_malloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+/*
+ * AllocationCount is a test hook: linking AllocationCount.cpp replaces every
+ * replaceable form of operator new and delete (single and array, plain and
+ * nothrow, and the sized deletes where the compiler has them) with versions
+ * that count allocations through one counter. 'make main_alloc_check' links
+ * it so the game loop can check that frames stop allocating once warmed up.
+ *
+ * (The replacements live in their own translation unit so that no caller can
+ * inline them and see a new paired with free().)
+ *
+ * Example:
+ *   uint64_t before = allocation_count();
+ *   //...frame...
+ *   if (allocation_count() != before) std::cerr << "frame allocated" << std::endl;
+ */
+
+#include <cstdint>
+
+//heap allocations made so far through operator new, from any thread:
+uint64_t allocation_count();
@@ -0,0 +1,148 @@
+#include "BallField.hpp"
+#include "Random.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+BallField::BallField(uint32_t count_, uint32_t seed, float max_radius) : count(count_) {
+	//a fifth of the court's area of 4 square units:
+	radius = std::min(max_radius, std::sqrt(0.2f * 4.0f / (3.14159265f * std::max(count, 1u))));
+
+	//cells at least one ball across, so touching balls are in the same or adjacent cells:
+	cells_per_side = std::max(1u, std::min(2048u, uint32_t(2.0f / (2.0f * radius))));
+	cell_size = 2.0f / cells_per_side;
+
+	RandomStream random(seed, 0);
+	x.resize(count);
+	y.resize(count);
+	vx.resize(count);
+	vy.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		x[i] = (random.next_float() * 2.0f - 1.0f) * (1.0f - radius);
+		y[i] = (random.next_float() * 2.0f - 1.0f) * (1.0f - radius);
+		vx[i] = random.next_float() - 0.5f;
+		vy[i] = random.next_float() - 0.5f;
+	}
+
+	ball_cell.resize(count);
+	cell_start.resize(cells_per_side * cells_per_side + 1);
+	cell_balls.resize(count);
+}
+
+void BallField::step(float dt) {
+	typedef std::chrono::high_resolution_clock Clock;
+	auto ms = [](Clock::time_point a, Clock::time_point b) {
+		return std::chrono::duration< double, std::milli >(b - a).count();
+	};
+
+	auto before = Clock::now();
+	//move, bouncing off the court edges:
+	float const lo = -1.0f + radius;
+	float const hi = 1.0f - radius;
+	for (uint32_t i = 0; i < count; ++i) {
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+		if (x[i] < lo) { x[i] = lo; vx[i] = std::abs(vx[i]); }
+		if (x[i] > hi) { x[i] = hi; vx[i] = -std::abs(vx[i]); }
+		if (y[i] < lo) { y[i] = lo; vy[i] = std::abs(vy[i]); }
+		if (y[i] > hi) { y[i] = hi; vy[i] = -std::abs(vy[i]); }
+	}
+	auto integrated = Clock::now();
+	build_grid();
+	auto built = Clock::now();
+	collide();
+	auto collided = Clock::now();
+
+	timings.integrate_ms += ms(before, integrated);
+	timings.grid_ms += ms(integrated, built);
+	timings.narrowphase_ms += ms(built, collided);
+	timings.steps += 1;
+}
+
+void BallField::build_grid() {
+	uint32_t cells = cells_per_side * cells_per_side;
+	std::fill(cell_start.begin(), cell_start.end(), 0);
+
+	//count balls per cell (cell_start[c + 1] holds cell c's count for now):
+	for (uint32_t i = 0; i < count; ++i) {
+		int32_t cx = int32_t((x[i] + 1.0f) / cell_size);
+		int32_t cy = int32_t((y[i] + 1.0f) / cell_size);
+		cx = std::max(0, std::min(int32_t(cells_per_side) - 1, cx));
+		cy = std::max(0, std::min(int32_t(cells_per_side) - 1, cy));
+		uint32_t cell = uint32_t(cy) * cells_per_side + uint32_t(cx);
+		ball_cell[i] = cell;
+		cell_start[cell + 1] += 1;
+	}
+	//prefix sum, so cell_start[c] is where cell c begins:
+	for (uint32_t c = 0; c < cells; ++c) {
+		cell_start[c + 1] += cell_start[c];
+	}
+	//scatter, using cell_start[c] as cell c's write position, which leaves it at the cell's end...
+	for (uint32_t i = 0; i < count; ++i) {
+		cell_balls[cell_start[ball_cell[i]]++] = i;
+	}
+	//...so shift everything back down by one cell:
+	for (uint32_t c = cells; c > 0; --c) {
+		cell_start[c] = cell_start[c - 1];
+	}
+	cell_start[0] = 0;
+}
+
+void BallField::collide() {
+	float const touch = 2.0f * radius;
+	uint64_t pairs_tested = 0;
+	uint64_t contacts = 0;
+
+	//push a touching pair apart and, if they are approaching, swap their velocities along
+	// the line between them (an elastic collision of equal masses):
+	auto resolve = [&](uint32_t a, uint32_t b) {
+		pairs_tested += 1;
+		float dx = x[b] - x[a];
+		float dy = y[b] - y[a];
+		float d2 = dx * dx + dy * dy;
+		if (d2 >= touch * touch || d2 == 0.0f) return;
+		float d = std::sqrt(d2);
+		float nx = dx / d, ny = dy / d;
+		float push = 0.5f * (touch - d);
+		x[a] -= push * nx; y[a] -= push * ny;
+		x[b] += push * nx; y[b] += push * ny;
+		float approach = (vx[b] - vx[a]) * nx + (vy[b] - vy[a]) * ny;
+		if (approach < 0.0f) {
+			vx[a] += approach * nx; vy[a] += approach * ny;
+			vx[b] -= approach * nx; vy[b] -= approach * ny;
+		}
+		contacts += 1;
+	};
+
+	//each cell against itself and four of its neighbors (right, and the three above),
+	// so every adjacent pair of cells is visited once:
+	static const int32_t Neighbors[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+	int32_t const side = int32_t(cells_per_side);
+	for (int32_t cy = 0; cy < side; ++cy) {
+		for (int32_t cx = 0; cx < side; ++cx) {
+			uint32_t cell = uint32_t(cy * side + cx);
+			uint32_t begin = cell_start[cell], end = cell_start[cell + 1];
+			if (begin == end) continue;
+			for (uint32_t i = begin; i < end; ++i) {
+				for (uint32_t j = i + 1; j < end; ++j) {
+					resolve(cell_balls[i], cell_balls[j]);
+				}
+			}
+			for (auto const &n : Neighbors) {
+				int32_t nx = cx + n[0], ny = cy + n[1];
+				if (nx < 0 || nx >= side || ny >= side) continue;
+				uint32_t other = uint32_t(ny * side + nx);
+				uint32_t other_begin = cell_start[other], other_end = cell_start[other + 1];
+				for (uint32_t i = begin; i < end; ++i) {
+					for (uint32_t j = other_begin; j < other_end; ++j) {
+						resolve(cell_balls[i], cell_balls[j]);
+					}
+				}
+			}
+		}
+	}
+
+	timings.pairs_tested += pairs_tested;
+	timings.contacts += contacts;
+}
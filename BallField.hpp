@@ -0,0 +1,57 @@
+#pragma once
+/*
+ * BallField simulates many equal balls (up to 100k) bouncing around the
+ * [-1,1]x[-1,1] court and off each other, as a stress test for physics and
+ * drawing ('./main --balls N').
+ *
+ * Each step integrates the balls, then finds touching pairs through a
+ * uniform grid whose cells are at least one ball across, so a ball can only
+ * touch balls in its own cell and the eight around it. The grid is rebuilt
+ * every step with a counting sort (count balls per cell, prefix-sum the
+ * counts, scatter ball indices), which costs O(balls + cells) and needs no
+ * allocation after construction.
+ *
+ * Example:
+ *   BallField field(10000, seed);
+ *   field.step(1.0f / 240.0f);
+ *   //field.x[i], field.y[i] are ball i's center; field.timings has per-phase times
+ */
+
+#include <vector>
+#include <cstdint>
+
+struct BallField {
+	//'count' balls at random positions and velocities; the radius is chosen so they
+	// cover about a fifth of the court (at most 'max_radius'):
+	BallField(uint32_t count, uint32_t seed, float max_radius = 0.02f);
+
+	void step(float dt);
+
+	uint32_t count;
+	float radius;
+
+	//per-ball state (structure-of-arrays):
+	std::vector< float > x, y;
+	std::vector< float > vx, vy;
+
+	//time spent in each phase and work done, summed over steps (reset by the caller):
+	struct Timings {
+		double integrate_ms = 0.0;
+		double grid_ms = 0.0;
+		double narrowphase_ms = 0.0;
+		uint64_t steps = 0;
+		uint64_t pairs_tested = 0;
+		uint64_t contacts = 0;
+	} timings;
+
+	//broadphase grid, rebuilt by step():
+	uint32_t cells_per_side;
+	float cell_size;
+	std::vector< uint32_t > ball_cell; //cell of each ball
+	std::vector< uint32_t > cell_start; //balls in cell c are cell_balls[cell_start[c] .. cell_start[c+1])
+	std::vector< uint32_t > cell_balls; //ball indices, sorted by cell
+
+private:
+	void build_grid();
+	void collide();
+};
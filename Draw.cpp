@@ -1,114 +1,740 @@
 #include "Draw.hpp"
 #include "GL.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <stdexcept>
 
-void Draw::add_rectangle(glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color) {
-	//split rectangle into two triangles, and add both to vertex list:
+DrawStreamStats draw_stream_stats;
+DrawCounters draw_counters;
 
-	vertices.emplace_back(glm::vec2(min.x, min.y), color);
-	vertices.emplace_back(glm::vec2(max.x, min.y), color);
-	vertices.emplace_back(glm::vec2(max.x, max.y), color);
-
-	vertices.emplace_back(glm::vec2(min.x, min.y), color);
-	vertices.emplace_back(glm::vec2(max.x, max.y), color);
-	vertices.emplace_back(glm::vec2(min.x, max.y), color);
+//is glBufferStorage (GL 4.4, or ARB_buffer_storage) available in the current context?
+static bool have_buffer_storage() {
+	#ifdef _WIN32
+	//(on windows it is only present if the driver provides it)
+	if (!glBufferStorage) return false;
+	#endif
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major > 4 || (major == 4 && minor >= 4)) return true;
+	GLint extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+	for (GLint i = 0; i < extensions; ++i) {
+		GLubyte const *name = glGetStringi(GL_EXTENSIONS, i);
+		if (name && std::strcmp(reinterpret_cast< char const * >(name), "GL_ARB_buffer_storage") == 0) return true;
+	}
+	return false;
 }
 
+//StreamRing is one buffer that vertex data is written into front-to-back,
+// wrapping around when it reaches the end. Each region is guarded by a fence
+// placed after the draw that reads it, and a write only waits when it catches
+// up to a region the GPU may still be using.
+// Where glBufferStorage is available the buffer is mapped once (persistent and
+// coherent) for its whole life and map() just hands out a pointer into it;
+// otherwise each write is an unsynchronized glMapBufferRange/glUnmapBuffer.
+struct StreamRing {
+	StreamRing() : persistent(have_buffer_storage()) {
+		allocate();
+		draw_stream_stats.persistent = persistent;
+		//fences are kept in a reserved vector so steady-state streaming doesn't allocate:
+		fences.reserve(64);
+	}
+	~StreamRing() {
+		for (auto const &f : fences) glDeleteSync(f.sync);
+		release();
+	}
+	StreamRing(StreamRing const &) = delete;
+	StreamRing &operator=(StreamRing const &) = delete;
+
+	//make a buffer of 'size' bytes (mapping it, if persistent):
+	void allocate() {
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		if (persistent) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+			mapped = reinterpret_cast< uint8_t * >(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+			if (!mapped) {
+				throw std::runtime_error("failed to map stream buffer");
+			}
+		} else {
+			glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+		}
+		generation += 1;
+	}
+	void release() {
+		if (mapped) {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			mapped = nullptr;
+		}
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+
+	//copy 'bytes' of 'data' into the ring at a multiple of 'alignment'; returns the offset written to:
+	GLintptr upload(void const *data, GLsizeiptr bytes, GLsizeiptr alignment) {
+		GLintptr offset = 0;
+		std::memcpy(map(bytes, alignment, &offset), data, bytes);
+		unmap();
+		return offset;
+	}
+
+	//map 'bytes' of the ring at a multiple of 'alignment' for writing (sets 'offset' to where);
+	// call unmap() once the data is written:
+	void *map(GLsizeiptr bytes, GLsizeiptr alignment, GLintptr *offset) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+		if (bytes > size) {
+			//new storage leaves pending draws reading the old storage, so outstanding fences can go
+			// (persistent storage can't be re-specified, so that takes a new buffer, and 'generation' changes):
+			while (size < bytes) size *= 2;
+			if (persistent) {
+				release();
+				allocate();
+			} else {
+				glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+			}
+			for (auto const &f : fences) glDeleteSync(f.sync);
+			fences.clear();
+			head = 0;
+			draw_stream_stats.grows += 1;
+		}
+
+		head = (head + alignment - 1) / alignment * alignment;
+		if (head + bytes > size) {
+			head = 0;
+			draw_stream_stats.wraps += 1;
+		}
+
+		//retire fences the GPU has already passed, so the list stays short:
+		auto passed = fences.begin();
+		while (passed != fences.end() && glClientWaitSync(passed->sync, 0, 0) == GL_ALREADY_SIGNALED) {
+			glDeleteSync(passed->sync);
+			++passed;
+		}
+		fences.erase(fences.begin(), passed);
+
+		//wait for (and retire) fences guarding anything in [head, head + bytes):
+		for (auto f = fences.begin(); f != fences.end(); ) {
+			if (f->begin < head + bytes && head < f->end) {
+				GLenum result = glClientWaitSync(f->sync, 0, 0);
+				if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+					draw_stream_stats.fence_waits += 1;
+					while (glClientWaitSync(f->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL) == GL_TIMEOUT_EXPIRED) { }
+				}
+				glDeleteSync(f->sync);
+				f = fences.erase(f);
+			} else {
+				++f;
+			}
+		}
+
+		void *ptr = nullptr;
+		if (persistent) {
+			ptr = mapped + head;
+		} else {
+			ptr = glMapBufferRange(GL_ARRAY_BUFFER, head, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+		}
+		if (!ptr) {
+			throw std::runtime_error("failed to map stream buffer");
+		}
+
+		*offset = head;
+		head += bytes;
+		draw_stream_stats.bytes_streamed += bytes;
+		return ptr;
+	}
+
+	void unmap() {
+		if (persistent) return; //(coherent, so the writes are already visible to later draws)
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	//call after issuing the draw that reads [offset, offset + bytes):
+	void fence(GLintptr offset, GLsizeiptr bytes) {
+		fences.emplace_back(Fence{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), offset, offset + bytes});
+	}
+
+	bool persistent;
+	uint8_t *mapped = nullptr; //(if persistent)
+	GLuint buffer = 0;
+	uint32_t generation = 0; //changes whenever 'buffer' is replaced
+	GLsizeiptr size = 4 * 1024 * 1024;
+	GLsizeiptr head = 0;
+	struct Fence {
+		GLsync sync;
+		GLintptr begin, end;
+	};
+	std::vector< Fence > fences; //in submission order
+};
+
+//QuadIndices is one index buffer holding two triangles per quad
+// (0,1,2, 0,2,3, 4,5,6, 4,6,7, ...), shared by every Draw and Batch and
+// extended whenever a draw needs more quads than it holds:
+struct QuadIndices {
+	QuadIndices() {
+		glGenBuffers(1, &buffer);
+		reserve(1024);
+	}
+	~QuadIndices() {
+		glDeleteBuffers(1, &buffer);
+	}
+	QuadIndices(QuadIndices const &) = delete;
+	QuadIndices &operator=(QuadIndices const &) = delete;
+
+	//make sure there are indices for at least 'count' quads:
+	void reserve(GLsizei count) {
+		if (count <= quads) return;
+		quads = std::max(count, 2 * quads);
+
+		std::vector< GLuint > indices;
+		indices.reserve(6 * quads);
+		for (GLuint q = 0; q < GLuint(quads); ++q) {
+			indices.emplace_back(4 * q + 0);
+			indices.emplace_back(4 * q + 1);
+			indices.emplace_back(4 * q + 2);
+			indices.emplace_back(4 * q + 0);
+			indices.emplace_back(4 * q + 2);
+			indices.emplace_back(4 * q + 3);
+		}
+		//(upload through the copy-write target so whatever VAO is bound is left alone)
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	}
+
+	GLuint buffer = 0;
+	GLsizei quads = 0;
+};
+
 static GLuint compile_shader(GLenum type, std::string const &source);
+static void link_program(GLuint program);
+
+//attribute locations for program (as every vertex format's setup_attributes() uses them):
+#define program_Position 0
+#define program_Color 1
+
+//attribute locations for DrawInstanced's program:
+#define instanced_program_Min 0
+#define instanced_program_Max 1
+#define instanced_program_Color 2
+
+//STR( program_Position ) evaluates to a quoted version of program_Position, i.e., "0"
+#define STR_( X ) # X
+#define STR( X ) STR_( X )
+
+//ProgramCache builds programs from source, optionally keeping each linked
+// program's binary (glGetProgramBinary) in a file named by a hash of the driver
+// strings and shader source. Later runs load the binary with glProgramBinary,
+// and quietly fall back to compiling if the driver rejects it.
+struct ProgramCache {
+	ProgramCache(std::string const &prefix_) : prefix(prefix_) {
+		if (prefix.empty()) return;
+
+		#ifdef _WIN32
+		//(on windows these are only present if the driver provides them)
+		if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri) return;
+		#endif
 
-void Draw::draw() {
-	//draw() uses a very simple vertex and fragment shader, which is compiled the first time the draw() function is called.
-
-	//----- initialization code -----
-
-	//attribute locations for program:
-	#define program_Position 0
-	#define program_Color 1
-	static GLuint program = [](){
-		GLuint program = 0;
-
-		//STR( program_Position ) evaluates to a quoted version of program_Position, i.e., "0"
-		#define STR_( X ) # X
-		#define STR( X ) STR_( X )
-		GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER,
-			"#version 330\n"
-			"layout(location = " STR(program_Position) ") in vec4 Position;\n"
-			"layout(location = " STR(program_Color) ") in vec4 Color;\n"
-			"out vec4 color;\n"
-			"void main() {\n"
-			"	gl_Position = Position;\n"
-			"	color = Color;\n"
-			"}\n"
-		);
-
-		GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER,
-			"#version 330\n"
-			"in vec4 color;\n"
-			"out vec4 fragColor;\n"
-			"void main() {\n"
-			"	fragColor = color;\n"
-			"}\n"
-		);
-
-		program = glCreateProgram();
+		//no binary formats (or no ARB_get_program_binary, which leaves this 0 with an error) means no cache:
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		while (glGetError() != GL_NO_ERROR) { }
+		if (formats <= 0) return;
+
+		enabled = true;
+		for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+			GLubyte const *str = glGetString(name);
+			driver += (str ? reinterpret_cast< char const * >(str) : "");
+			driver += '\n';
+		}
+	}
+
+	//a linked program with the given sources; 'attributes' are bound to locations 0, 1, ... in order:
+	GLuint build(std::string const &vertex_source, std::string const &fragment_source, std::vector< char const * > const &attributes) {
+		std::string path;
+		if (enabled) {
+			std::string key = driver + vertex_source + '\0' + fragment_source;
+			for (auto const &a : attributes) {
+				key += '\0'; //(separated, so {"ab","c"} and {"a","bc"} get different keys)
+				key += a;
+			}
+			path = prefix + "program-" + hash(key) + ".bin";
+			GLuint program = load(path);
+			if (program) {
+				cached += 1;
+				return program;
+			}
+		}
+
+		GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+		GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+		GLuint program = glCreateProgram();
 		glAttachShader(program, vertex_shader);
 		glAttachShader(program, fragment_shader);
 		//shaders are reference counted so this makes sure they are freed after program is deleted:
 		glDeleteShader(vertex_shader);
 		glDeleteShader(fragment_shader);
 
-		glLinkProgram(program);
+		for (GLuint i = 0; i < attributes.size(); ++i) {
+			glBindAttribLocation(program, i, attributes[i]);
+		}
+		if (enabled) {
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
+		link_program(program);
+		compiled += 1;
+
+		if (enabled) save(program, path);
+		return program;
+	}
+
+	//64-bit FNV-1a, as hex:
+	static std::string hash(std::string const &key) {
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (char c : key) {
+			h = (h ^ uint8_t(c)) * 0x100000001b3ULL;
+		}
+		char buf[17];
+		snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+		return buf;
+	}
+
+	//cache files are a magic number, the binary format, then the binary:
+	static constexpr uint32_t Magic = 0x31425044; //"DPB1"
+
+	GLuint load(std::string const &path) {
+		std::ifstream file(path, std::ios::binary);
+		uint32_t magic = 0;
+		uint32_t format = 0;
+		if (!file.read(reinterpret_cast< char * >(&magic), 4)) return 0;
+		if (!file.read(reinterpret_cast< char * >(&format), 4)) return 0;
+		if (magic != Magic) return 0;
+		std::vector< char > binary((std::istreambuf_iterator< char >(file)), std::istreambuf_iterator< char >());
+		if (binary.empty()) return 0;
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, format, binary.data(), binary.size());
 		GLint link_status = GL_FALSE;
 		glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+		while (glGetError() != GL_NO_ERROR) { }
 		if (link_status != GL_TRUE) {
-			std::cerr << "Failed to link shader program." << std::endl;
-			GLint info_log_length = 0;
-			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
-			std::vector< GLchar > info_log(info_log_length, 0);
-			GLsizei length = 0;
-			glGetProgramInfoLog(program, info_log.size(), &length, &info_log[0]);
-			std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
-			throw std::runtime_error("failed to link program");
+			//(stale driver, corrupt file, ...) -- compiling will replace it
+			glDeleteProgram(program);
+			return 0;
 		}
 		return program;
-	}();
+	}
 
-	//we also need a buffer and a VAO to reference said buffer:
-	static GLuint buffer = [](){
-		GLuint buffer;
-		glGenBuffers(1, &buffer);
-		glBindBuffer(GL_ARRAY_BUFFER, buffer);
-		return buffer;
-	}();
+	void save(GLuint program, std::string const &path) {
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return;
+		std::vector< char > binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		while (glGetError() != GL_NO_ERROR) { }
 
-	static GLuint vao = [](){
-		GLuint vao;
-		glGenVertexArrays(1, &vao);
-		glBindVertexArray(vao);
-		glBindBuffer(GL_ARRAY_BUFFER, buffer);
-		glVertexAttribPointer(program_Position, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0);
-		glVertexAttribPointer(program_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLbyte *)0 + sizeof(glm::vec2));
-		glEnableVertexAttribArray(program_Position);
-		glEnableVertexAttribArray(program_Color);
-		return vao;
-	}();
+		std::ofstream file(path, std::ios::binary);
+		uint32_t magic = Magic;
+		uint32_t format32 = format;
+		file.write(reinterpret_cast< char const * >(&magic), 4);
+		file.write(reinterpret_cast< char const * >(&format32), 4);
+		file.write(binary.data(), length);
+	}
 
-	//------ actual drawing ------
+	std::string prefix;
+	bool enabled = false;
+	std::string driver; //vendor, renderer and version strings
+	uint32_t cached = 0;
+	uint32_t compiled = 0;
+};
 
-	//send vertices to graphics card:
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STREAM_DRAW);
+//BasicDraw uses a very simple vertex and fragment shader, which is built when the DrawContext is created.
+// Positions are mapped through 'Offset + Scale * Position' and colors multiplied by 'Tint',
+// which is how retained batches get moved and recolored without re-uploading them.
+// The vertex format supplies the code that declares and decodes 'Color'.
+struct DrawProgram {
+	GLuint program = 0;
+	GLint Offset = -1;
+	GLint Scale = -1;
+	GLint Tint = -1;
+};
 
-	//draw vertices:
-	glUseProgram(program);
-	glBindVertexArray(vao);
-	glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+template< typename Format >
+static DrawProgram make_draw_program(ProgramCache &cache) {
+	DrawProgram ret;
+
+	std::string vertex_source = std::string(
+		"#version 330\n"
+		"uniform vec2 Offset;\n"
+		"uniform vec2 Scale;\n"
+		"uniform vec4 Tint;\n"
+		"in vec2 Position;\n")
+		+ Format::color_glsl() +
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = vec4(Offset + Scale * Position, 0.0, 1.0);\n"
+		"	color = Tint * color_of();\n"
+		"}\n";
+
+	std::string fragment_source =
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n";
 
-	//clear vertex list:
+	//attribute locations as in Format::setup_attributes():
+	ret.program = cache.build(vertex_source, fragment_source, {"Position", "Color"});
+
+	ret.Offset = glGetUniformLocation(ret.program, "Offset");
+	ret.Scale = glGetUniformLocation(ret.program, "Scale");
+	ret.Tint = glGetUniformLocation(ret.program, "Tint");
+	return ret;
+}
+
+//Programs and VAOs for one vertex format:
+struct FormatObjects {
+	DrawProgram program;
+	GLuint vao = 0; //reads from the stream ring
+	uint32_t vao_generation = 0; //the ring's 'generation' when 'vao' was pointed at it
+};
+
+//Everything a DrawContext owns:
+struct DrawContext::Internals {
+	Internals(std::string const &program_cache_prefix);
+	~Internals();
+
+	ProgramCache cache; //(only used while constructing)
+	StreamRing ring;
+	QuadIndices indices;
+	//one per vertex format instantiated below:
+	FormatObjects position_color;
+	FormatObjects palette;
+	GLuint palette_texture = 0; //256x1 RGBA8, read by the palette program through texture unit 0
+	//for DrawInstanced:
+	GLuint instanced_program = 0;
+	GLuint instanced_vao = 0;
+};
+
+static DrawContext *current_context = nullptr;
+
+static DrawContext::Internals &internals() {
+	if (!current_context) {
+		throw std::runtime_error("Draw used without a DrawContext.");
+	}
+	return *current_context->internals;
+}
+
+static StreamRing &stream_ring() {
+	return internals().ring;
+}
+
+static QuadIndices &quad_indices() {
+	return internals().indices;
+}
+
+template< typename Format >
+static FormatObjects &format_objects();
+
+template< >
+FormatObjects &format_objects< PositionColorVertex >() {
+	return internals().position_color;
+}
+
+template< >
+FormatObjects &format_objects< PaletteVertex >() {
+	return internals().palette;
+}
+
+template< typename Format >
+static DrawProgram const &draw_program() {
+	return format_objects< Format >().program;
+}
+
+//set up vertex attributes for the buffer currently bound to GL_ARRAY_BUFFER,
+// and attach the shared quad indices to the currently bound VAO:
+template< typename Format >
+static void setup_vertex_attribs(GLuint quad_index_buffer) {
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_index_buffer);
+	Format::setup_attributes();
+}
+
+//bind anything besides uniforms a format's program reads:
+template< typename Format >
+static void bind_format_textures();
+
+template< >
+void bind_format_textures< PositionColorVertex >() {
+}
+
+template< >
+void bind_format_textures< PaletteVertex >() {
+	//(the 'Palette' sampler is left at its default, unit 0)
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, internals().palette_texture);
+}
+
+//use the program with the given transform:
+template< typename Format >
+static void use_draw_program(glm::vec2 const &offset, glm::vec2 const &scale, glm::u8vec4 const &tint) {
+	DrawProgram const &p = draw_program< Format >();
+	glUseProgram(p.program);
+	bind_format_textures< Format >();
+	glUniform2f(p.Offset, offset.x, offset.y);
+	glUniform2f(p.Scale, scale.x, scale.y);
+	glUniform4f(p.Tint, tint.x / 255.0f, tint.y / 255.0f, tint.z / 255.0f, tint.w / 255.0f);
+}
+
+template< typename Format >
+void BasicDraw< Format >::reserve(uint32_t rectangles) {
+	vertices.reserve(4 * rectangles);
+	if (optimize) optimize_scratch.reserve(rectangles);
+}
+
+//add the four corners; the shared index buffer splits them into two triangles:
+template< typename Vertex >
+static void add_corners(std::vector< Vertex > &vertices, glm::vec2 const &min, glm::vec2 const &max, typename Vertex::Color const &color) {
+	vertices.emplace_back(glm::vec2(min.x, min.y), color);
+	vertices.emplace_back(glm::vec2(max.x, min.y), color);
+	vertices.emplace_back(glm::vec2(max.x, max.y), color);
+	vertices.emplace_back(glm::vec2(min.x, max.y), color);
+}
+
+template< typename Format >
+void BasicDraw< Format >::add_rectangle(glm::vec2 const &min, glm::vec2 const &max, typename Vertex::Color const &color) {
+	add_corners(vertices, min, max, color);
+}
+
+template< typename Format >
+void BasicDraw< Format >::Recorder::add_rectangle(glm::vec2 const &min, glm::vec2 const &max, typename Vertex::Color const &color) {
+	add_corners(vertices, min, max, color);
+}
+
+template< typename Format >
+void BasicDraw< Format >::set_recorders(uint32_t count) {
+	if (recorders.size() < count) recorders.resize(count);
+}
+
+template< typename Format >
+size_t BasicDraw< Format >::pending_vertices() const {
+	size_t count = vertices.size();
+	for (auto const &r : recorders) count += r.vertices.size();
+	return count;
+}
+
+//copy 'vertices', then every recorder's vertices in index order, to 'dst'; clears them all:
+template< typename Format >
+void BasicDraw< Format >::gather(Vertex *dst) {
+	std::memcpy(dst, vertices.data(), sizeof(Vertex) * vertices.size());
+	dst += vertices.size();
 	vertices.clear();
+	for (auto &r : recorders) {
+		std::memcpy(dst, r.vertices.data(), sizeof(Vertex) * r.vertices.size());
+		dst += r.vertices.size();
+		r.vertices.clear();
+	}
+}
+
+template< typename Format >
+void BasicDraw< Format >::optimize_pending(bool cull) {
+	//bring recorded vertices into 'vertices' so they are optimized together:
+	for (auto &r : recorders) {
+		vertices.insert(vertices.end(), r.vertices.begin(), r.vertices.end());
+		r.vertices.clear();
+	}
+
+	std::vector< Quad > &quads = optimize_scratch;
+	quads.clear();
+	optimize_stats.rects_in = vertices.size() / 4;
+
+	//corners 0 and 2 of each quad, sorted so lo < hi; dropping zero-area and (if 'cull') off-screen quads:
+	for (size_t i = 0; i + 3 < vertices.size(); i += 4) {
+		Quad q{vertices[i], vertices[i+2]};
+		if (q.hi.v.x < q.lo.v.x) std::swap(q.lo.v.x, q.hi.v.x);
+		if (q.hi.v.y < q.lo.v.y) std::swap(q.lo.v.y, q.hi.v.y);
+		if (!(q.lo.v.x < q.hi.v.x && q.lo.v.y < q.hi.v.y)) continue;
+		if (cull) {
+			glm::vec2 lo = q.lo.position();
+			glm::vec2 hi = q.hi.position();
+			if (hi.x <= -1.0f || lo.x >= 1.0f || hi.y <= -1.0f || lo.y >= 1.0f) continue;
+		}
+		quads.emplace_back(q);
+	}
+
+	//within each run of same-color quads (whose order doesn't matter), merge quads that share a full edge:
+	size_t kept = 0;
+	for (size_t run = 0; run < quads.size(); ) {
+		size_t run_end = run + 1;
+		while (run_end < quads.size() && quads[run_end].lo.c == quads[run].lo.c) ++run_end;
+
+		auto begin = quads.begin() + run;
+		auto end = quads.begin() + run_end;
+		bool merged = true;
+		while (merged && end - begin > 1) {
+			merged = false;
+			//side by side: same y span, one's right edge is the other's left edge:
+			std::sort(begin, end, [](Quad const &a, Quad const &b) {
+				if (a.lo.v.y != b.lo.v.y) return a.lo.v.y < b.lo.v.y;
+				if (a.hi.v.y != b.hi.v.y) return a.hi.v.y < b.hi.v.y;
+				return a.lo.v.x < b.lo.v.x;
+			});
+			auto out = begin;
+			for (auto q = begin + 1; q != end; ++q) {
+				if (q->lo.v.y == out->lo.v.y && q->hi.v.y == out->hi.v.y && q->lo.v.x == out->hi.v.x) {
+					out->hi.v.x = q->hi.v.x;
+					merged = true;
+				} else {
+					*(++out) = *q;
+				}
+			}
+			end = out + 1;
+			//stacked: same x span, one's top edge is the other's bottom edge:
+			std::sort(begin, end, [](Quad const &a, Quad const &b) {
+				if (a.lo.v.x != b.lo.v.x) return a.lo.v.x < b.lo.v.x;
+				if (a.hi.v.x != b.hi.v.x) return a.hi.v.x < b.hi.v.x;
+				return a.lo.v.y < b.lo.v.y;
+			});
+			out = begin;
+			for (auto q = begin + 1; q != end; ++q) {
+				if (q->lo.v.x == out->lo.v.x && q->hi.v.x == out->hi.v.x && q->lo.v.y == out->hi.v.y) {
+					out->hi.v.y = q->hi.v.y;
+					merged = true;
+				} else {
+					*(++out) = *q;
+				}
+			}
+			end = out + 1;
+		}
+
+		//pack the run's survivors after the previous runs':
+		kept = std::copy(begin, end, quads.begin() + kept) - quads.begin();
+		run = run_end;
+	}
+	quads.erase(quads.begin() + kept, quads.end());
+
+	//back to four corners each:
+	vertices.clear();
+	for (auto const &q : quads) {
+		vertices.emplace_back(q.lo);
+		vertices.emplace_back(q.hi);
+		vertices.back().v.y = q.lo.v.y;
+		vertices.emplace_back(q.hi);
+		vertices.emplace_back(q.lo);
+		vertices.back().v.y = q.hi.v.y;
+	}
+	optimize_stats.rects_out = quads.size();
+}
+
+template< typename Format >
+void BasicDraw< Format >::draw() {
+	if (optimize) optimize_pending(true);
+	size_t count = pending_vertices();
+	if (count == 0) return;
+
+	//send vertices to graphics card (offset is vertex-aligned so it can be used as the base vertex):
+	GLsizeiptr bytes = sizeof(Vertex) * count;
+	GLintptr offset = 0;
+	gather(reinterpret_cast< Vertex * >(stream_ring().map(bytes, sizeof(Vertex), &offset)));
+	stream_ring().unmap();
+
+	GLsizei quads = count / 4;
+	quad_indices().reserve(quads);
+
+	//draw quads:
+	use_draw_program< Format >(glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::u8vec4(0xff, 0xff, 0xff, 0xff));
+	FormatObjects &objects = format_objects< Format >();
+	glBindVertexArray(objects.vao);
+	if (objects.vao_generation != stream_ring().generation) {
+		//(the ring got a new buffer since the VAO was set up)
+		glBindBuffer(GL_ARRAY_BUFFER, stream_ring().buffer);
+		setup_vertex_attribs< Format >(quad_indices().buffer);
+		objects.vao_generation = stream_ring().generation;
+	}
+	glDrawElementsBaseVertex(GL_TRIANGLES, 6 * quads, GL_UNSIGNED_INT, (GLbyte *)0, offset / sizeof(Vertex));
+	stream_ring().fence(offset, bytes);
+
+	draw_counters.draw_calls += 1;
+	draw_counters.rectangles += quads;
+	draw_counters.vertices += count;
+	draw_counters.bytes_uploaded += bytes;
+}
+
+template< typename Format >
+typename BasicDraw< Format >::Batch BasicDraw< Format >::record() {
+	if (optimize) optimize_pending(false);
+	size_t count = pending_vertices();
+
+	Batch batch;
+	batch.quads = count / 4;
+	quad_indices().reserve(batch.quads);
+
+	//batches get their own buffer, written once:
+	glGenBuffers(1, &batch.buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * count, NULL, GL_STATIC_DRAW);
+	if (count) {
+		void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * count, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (!ptr) {
+			throw std::runtime_error("failed to map batch buffer");
+		}
+		gather(reinterpret_cast< Vertex * >(ptr));
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		draw_counters.bytes_uploaded += sizeof(Vertex) * count;
+	}
+
+	glGenVertexArrays(1, &batch.vao);
+	glBindVertexArray(batch.vao);
+	setup_vertex_attribs< Format >(quad_indices().buffer);
+
+	return batch;
+}
+
+template< typename Format >
+void BasicDraw< Format >::draw(Batch const &batch, glm::vec2 const &offset, glm::vec2 const &scale, glm::u8vec4 const &tint) {
+	if (batch.quads == 0) return;
+	use_draw_program< Format >(offset, scale, tint);
+	glBindVertexArray(batch.vao);
+	glDrawElements(GL_TRIANGLES, 6 * batch.quads, GL_UNSIGNED_INT, (GLbyte *)0);
+
+	draw_counters.draw_calls += 1;
+	draw_counters.rectangles += batch.quads;
+	draw_counters.vertices += 4 * batch.quads;
+}
+
+template< typename Format >
+void BasicDraw< Format >::release(Batch &batch) {
+	glDeleteVertexArrays(1, &batch.vao);
+	glDeleteBuffers(1, &batch.buffer);
+	batch = Batch();
+}
+
+//the formats declared in Draw.hpp:
+template struct BasicDraw< PositionColorVertex >;
+template struct BasicDraw< PaletteVertex >;
+
+void set_draw_palette(std::vector< glm::u8vec4 > const &palette) {
+	//always all 256 entries, so a shorter palette doesn't leave an earlier one's colors past its end:
+	glm::u8vec4 entries[256];
+	for (uint32_t i = 0; i < 256; ++i) {
+		entries[i] = (i < palette.size() ? palette[i] : glm::u8vec4(0));
+	}
+	glBindTexture(GL_TEXTURE_2D, internals().palette_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, GL_RGBA, GL_UNSIGNED_BYTE, entries);
 }
 
 static GLuint compile_shader(GLenum type, std::string const &source) {
@@ -132,3 +758,209 @@ static GLuint compile_shader(GLenum type, std::string const &source) {
 	}
 	return shader;
 }
+
+static void link_program(GLuint program) {
+	glLinkProgram(program);
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+	if (link_status != GL_TRUE) {
+		std::cerr << "Failed to link shader program." << std::endl;
+		GLint info_log_length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
+		std::vector< GLchar > info_log(info_log_length, 0);
+		GLsizei length = 0;
+		glGetProgramInfoLog(program, info_log.size(), &length, &info_log[0]);
+		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
+		throw std::runtime_error("failed to link program");
+	}
+}
+
+void DrawInstanced::add_rectangle(glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color) {
+	instances.emplace_back(min, max, color);
+}
+
+void DrawInstanced::draw() {
+	//same idea as BasicDraw::draw(), but rectangles are sent as per-instance attributes
+	// and the four corners of each are generated in the vertex shader (see make_instanced_program()).
+
+	GLuint program = internals().instanced_program;
+	GLuint vao = internals().instanced_vao;
+
+	if (instances.empty()) return;
+
+	//send instances to graphics card:
+	GLsizeiptr bytes = sizeof(Instance) * instances.size();
+	GLintptr offset = stream_ring().upload(&instances[0], bytes, sizeof(Instance));
+
+	//there is no base instance in GL 3.3, so point the attributes at this upload:
+	glUseProgram(program);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, stream_ring().buffer);
+	glVertexAttribPointer(instanced_program_Min, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLbyte *)0 + offset);
+	glVertexAttribPointer(instanced_program_Max, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLbyte *)0 + offset + sizeof(glm::vec2));
+	glVertexAttribPointer(instanced_program_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance), (GLbyte *)0 + offset + 2 * sizeof(glm::vec2));
+
+	//draw one four-vertex strip per instance:
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances.size());
+	stream_ring().fence(offset, bytes);
+
+	draw_counters.draw_calls += 1;
+	draw_counters.rectangles += instances.size();
+	draw_counters.vertices += 4 * instances.size();
+	draw_counters.bytes_uploaded += bytes;
+
+	//clear instance list:
+	instances.clear();
+}
+
+static GLuint make_instanced_program(ProgramCache &cache) {
+	return cache.build(
+		"#version 330\n"
+		"layout(location = " STR(instanced_program_Min) ") in vec2 Min;\n"
+		"layout(location = " STR(instanced_program_Max) ") in vec2 Max;\n"
+		"layout(location = " STR(instanced_program_Color) ") in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		//corners in triangle strip order: (0,0) (1,0) (0,1) (1,1)
+		"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+		"	gl_Position = vec4(mix(Min, Max, corner), 0.0, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	, {});
+}
+
+static GLuint make_instanced_vao() {
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	//advance attributes once per rectangle rather than once per vertex:
+	glVertexAttribDivisor(instanced_program_Min, 1);
+	glVertexAttribDivisor(instanced_program_Max, 1);
+	glVertexAttribDivisor(instanced_program_Color, 1);
+	glEnableVertexAttribArray(instanced_program_Min);
+	glEnableVertexAttribArray(instanced_program_Max);
+	glEnableVertexAttribArray(instanced_program_Color);
+	return vao;
+}
+
+//------ DrawContext ------
+
+DrawContext::Internals::Internals(std::string const &program_cache_prefix) : cache(program_cache_prefix) {
+	position_color.program = make_draw_program< PositionColorVertex >(cache);
+	palette.program = make_draw_program< PaletteVertex >(cache);
+
+	//palette colors, all transparent black until set_draw_palette():
+	glGenTextures(1, &palette_texture);
+	glBindTexture(GL_TEXTURE_2D, palette_texture);
+	std::vector< glm::u8vec4 > black(256, glm::u8vec4(0));
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, black.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	//stream VAOs read from the ring buffer through the shared quad indices:
+	glGenVertexArrays(1, &position_color.vao);
+	glBindVertexArray(position_color.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+	setup_vertex_attribs< PositionColorVertex >(indices.buffer);
+	position_color.vao_generation = ring.generation;
+
+	glGenVertexArrays(1, &palette.vao);
+	glBindVertexArray(palette.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+	setup_vertex_attribs< PaletteVertex >(indices.buffer);
+	palette.vao_generation = ring.generation;
+
+	instanced_program = make_instanced_program(cache);
+	instanced_vao = make_instanced_vao();
+
+	glBindVertexArray(0);
+}
+
+DrawContext::Internals::~Internals() {
+	glBindVertexArray(0);
+	glUseProgram(0);
+	for (FormatObjects *f : {&position_color, &palette}) {
+		glDeleteVertexArrays(1, &f->vao);
+		glDeleteProgram(f->program.program);
+	}
+	glDeleteVertexArrays(1, &instanced_vao);
+	glDeleteProgram(instanced_program);
+	glDeleteTextures(1, &palette_texture);
+	//(ring and indices delete their own buffers)
+}
+
+DrawContext::DrawContext(std::string const &program_cache_prefix) {
+	if (current_context) {
+		throw std::runtime_error("Only one DrawContext may exist at a time.");
+	}
+	auto before = std::chrono::high_resolution_clock::now();
+	internals = new Internals(program_cache_prefix);
+	auto after = std::chrono::high_resolution_clock::now();
+	current_context = this;
+
+	programs_cached = internals->cache.cached;
+	programs_compiled = internals->cache.compiled;
+	setup_ms = std::chrono::duration< float, std::milli >(after - before).count();
+}
+
+DrawContext::~DrawContext() {
+	current_context = nullptr;
+	delete internals;
+	internals = nullptr;
+}
+
+void DrawContext::warm_up() {
+	//remember the framebuffer and viewport to restore afterward:
+	GLint old_framebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &old_framebuffer);
+	GLint old_viewport[4];
+	glGetIntegerv(GL_VIEWPORT, old_viewport);
+
+	//small offscreen target so nothing shows up in the window:
+	GLuint renderbuffer = 0;
+	glGenRenderbuffers(1, &renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 16, 16);
+	GLuint framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+	glViewport(0, 0, 16, 16);
+
+	//one streamed draw and one batch draw per path, then wait for the GPU to get through them:
+	glm::vec2 min(-0.5f, -0.5f), max(0.5f, 0.5f);
+	glm::u8vec4 white(0xff, 0xff, 0xff, 0xff);
+	{
+		Draw draw;
+		draw.add_rectangle(min, max, white);
+		draw.draw();
+		draw.add_rectangle(min, max, white);
+		Draw::Batch batch = draw.record();
+		draw.draw(batch, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), white);
+		Draw::release(batch);
+	}
+	{
+		PaletteDraw draw;
+		draw.add_rectangle(min, max, 0);
+		draw.draw();
+	}
+	{
+		DrawInstanced draw;
+		draw.add_rectangle(min, max, white);
+		draw.draw();
+	}
+	glFinish();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, old_framebuffer);
+	glViewport(old_viewport[0], old_viewport[1], old_viewport[2], old_viewport[3]);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &renderbuffer);
+}
@@ -4,32 +4,283 @@
  *
  * All drawing operations use [-1,1] x [-1,1] window coordinates.
  *
+ * The GL objects every Draw shares (programs, VAOs, buffers) belong to a
+ * DrawContext, which must be created after the GL context and destroyed
+ * before it. DrawContext::warm_up() exercises every path once, offscreen, so
+ * that the driver's first-use costs don't land in the first real frame.
+ *
+ * A Draw keeps its vertex storage between calls to draw(), so a long-lived
+ * Draw (reset by draw() each frame) doesn't allocate once it has warmed up.
+ *
  * Example:
  * //draws a red rectangle in the upper right quadrant of the window:
+ *   DrawContext context; //once, at startup
  *   Draw draw;
  *   draw.add_rect(glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
  *   draw.draw();
+ *
+ * Draw is BasicDraw over 12-byte float position + RGBA vertices; PaletteDraw
+ * uses 6-byte vertices (16-bit positions + palette index) to halve upload
+ * bandwidth when a few colors will do. Other formats can be added by
+ * following the description of vertex formats below.
+ *
+ * Rectangles can also be added from other threads through a Draw's
+ * 'recorders' (one per thread); draw() merges them in index order:
+ *   draw.set_recorders(2);
+ *   //...thread i calls draw.recorders[i].add_rectangle(...), then (after joining):
+ *   draw.draw();
+ *
+ * Geometry that doesn't change can be recorded once into a Batch and drawn
+ * each frame with only an offset/scale/tint:
+ *   draw.add_rectangle(glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::u8vec4(0xff, 0xff, 0xff, 0xff));
+ *   Draw::Batch square = draw.record();
+ *   //...every frame:
+ *   draw.draw(square, glm::vec2(0.5f, 0.5f), glm::vec2(0.1f, 0.1f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+ *
+ * DrawInstanced has the same interface, but stores each rectangle as a single
+ * instance record (20 bytes instead of 48) that is expanded to a quad in the
+ * vertex shader.
+ *
+ * Both stream their data through a shared ring buffer; the counters in
+ * 'draw_stream_stats' show how it is being used (lots of fence waits or grows
+ * mean the ring is undersized for the workload). 'draw_counters' keeps running
+ * totals of draw calls, rectangles, vertices and bytes uploaded; take the
+ * difference of two readings to get per-frame numbers.
  */
 
+#include "GL.hpp"
+
 #include <vector>
+#include <string>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+//----- vertex formats -----
+//BasicDraw is templated on a vertex format. Each format provides:
+// - a constructor from (position, color), where 'Color' is the type add_rectangle() takes;
+// - members 'v' (position, in any comparable type) and 'c' (color), and 'position()' decoding 'v' to a vec2;
+// - 'setup_attributes()': points attributes 0, 1 at its members (Position, then Color) with setup_draw_attribute();
+// - 'color_glsl()': vertex shader source declaring 'in ... Color' and a 'vec4 color_of()' that decodes it.
+
+//how OpenGL should read a member of a given type:
+template< typename T > struct DrawAttributeType;
+template< > struct DrawAttributeType< glm::vec2 > {
+	static constexpr GLint Size = 2; static constexpr GLenum Type = GL_FLOAT; static constexpr bool Normalized = false; static constexpr bool Integer = false;
+};
+template< > struct DrawAttributeType< glm::i16vec2 > {
+	static constexpr GLint Size = 2; static constexpr GLenum Type = GL_SHORT; static constexpr bool Normalized = true; static constexpr bool Integer = false;
+};
+template< > struct DrawAttributeType< glm::u8vec4 > {
+	static constexpr GLint Size = 4; static constexpr GLenum Type = GL_UNSIGNED_BYTE; static constexpr bool Normalized = true; static constexpr bool Integer = false;
+};
+template< > struct DrawAttributeType< uint8_t > {
+	static constexpr GLint Size = 1; static constexpr GLenum Type = GL_UNSIGNED_BYTE; static constexpr bool Normalized = false; static constexpr bool Integer = true;
+};
+
+//point attribute 'location' at a member of type T, 'offset' bytes into each
+// 'stride'-byte vertex of the buffer bound to GL_ARRAY_BUFFER:
+template< typename T >
+void setup_draw_attribute(GLuint location, size_t offset, GLsizei stride) {
+	typedef DrawAttributeType< T > Type;
+	GLbyte const *pointer = (GLbyte const *)0 + offset;
+	if (Type::Integer) {
+		glVertexAttribIPointer(location, Type::Size, Type::Type, stride, pointer);
+	} else {
+		glVertexAttribPointer(location, Type::Size, Type::Type, Type::Normalized ? GL_TRUE : GL_FALSE, stride, pointer);
+	}
+	glEnableVertexAttribArray(location);
+}
+
+//float position + RGBA color, 12 bytes:
+struct PositionColorVertex {
+	typedef glm::u8vec4 Color;
+	PositionColorVertex(glm::vec2 const &v_, glm::u8vec4 const &c_)
+		: v(v_), c(c_) {
+	}
+	glm::vec2 v;
+	glm::u8vec4 c;
+	glm::vec2 position() const { return v; }
+
+	static void setup_attributes() {
+		setup_draw_attribute< glm::vec2 >(0, offsetof(PositionColorVertex, v), sizeof(PositionColorVertex));
+		setup_draw_attribute< glm::u8vec4 >(1, offsetof(PositionColorVertex, c), sizeof(PositionColorVertex));
+	}
+	static char const *color_glsl() {
+		return
+			"in vec4 Color;\n"
+			"vec4 color_of() { return Color; }\n";
+	}
+};
+static_assert(sizeof(PositionColorVertex) == 12, "PositionColorVertex is tightly packed.");
+
+//16-bit normalized position + palette index, 6 bytes.
+// Positions are clamped to [-1,1]x[-1,1] (before any batch offset/scale) and
+// colors are looked up in the 256-entry palette set with set_draw_palette()
+// (kept in a 256x1 texture: as a uniform array it would need all 1024 of the
+// vertex uniform components GL 3.3 guarantees, leaving none for the transform):
+struct PaletteVertex {
+	typedef uint8_t Color;
+	PaletteVertex(glm::vec2 const &v_, uint8_t c_)
+		: v(snorm(v_.x), snorm(v_.y)), c(c_), pad(0) {
+	}
+	glm::i16vec2 v;
+	uint8_t c;
+	uint8_t pad; //keeps the next vertex's position 2-byte aligned
+	glm::vec2 position() const { return glm::vec2(v) / 32767.0f; }
+
+	static void setup_attributes() {
+		setup_draw_attribute< glm::i16vec2 >(0, offsetof(PaletteVertex, v), sizeof(PaletteVertex));
+		setup_draw_attribute< uint8_t >(1, offsetof(PaletteVertex, c), sizeof(PaletteVertex));
+	}
+	static char const *color_glsl() {
+		return
+			"in uint Color;\n"
+			"uniform sampler2D Palette;\n"
+			"vec4 color_of() { return texelFetch(Palette, ivec2(int(Color), 0), 0); }\n";
+	}
+
+	static int16_t snorm(float x) {
+		return int16_t(std::round(glm::clamp(x, -1.0f, 1.0f) * 32767.0f));
+	}
+};
+static_assert(sizeof(PaletteVertex) == 6, "PaletteVertex is tightly packed.");
+
+template< typename Format >
+struct BasicDraw {
+	typedef Format Vertex;
+
+	//add rectangle [min.x,max.x] x [min.y,max.y] in color 'color':
+	void add_rectangle(glm::vec2 const &min, glm::vec2 const &max, typename Vertex::Color const &color);
+	//draw all rectangles added since last call to draw():
+	void draw();
+	//make room for 'rectangles' rectangles without reallocating (set 'optimize' first to include room to optimize them):
+	void reserve(uint32_t rectangles);
+
+	//----- retained geometry -----
+	//geometry stored in its own GPU buffer:
+	struct Batch {
+		GLuint buffer = 0;
+		GLuint vao = 0;
+		GLsizei quads = 0;
+	};
+	//move all rectangles added since last call to draw() into a new Batch:
+	Batch record();
+	//draw 'batch' immediately, with positions mapped to offset + scale * position and colors multiplied by tint:
+	void draw(Batch const &batch, glm::vec2 const &offset, glm::vec2 const &scale, glm::u8vec4 const &tint);
+	//free the GPU resources held by 'batch':
+	static void release(Batch &batch);
+
+	//----- multi-threaded recording -----
+	//A Recorder collects rectangles without touching GL, so several threads can
+	// each fill their own at once. draw() and record() take this Draw's own
+	// rectangles followed by recorders[0], recorders[1], ... -- index order, not
+	// the order threads finished in -- as one upload and one draw call.
+	struct Recorder {
+		//add rectangle [min.x,max.x] x [min.y,max.y] in color 'color':
+		void add_rectangle(glm::vec2 const &min, glm::vec2 const &max, typename Vertex::Color const &color);
+		std::vector< Vertex > vertices;
+	};
+	//make sure there are at least 'count' recorders (call before handing them to other threads):
+	void set_recorders(uint32_t count);
+	std::vector< Recorder > recorders;
+
+	//----- geometry optimization -----
+	//If 'optimize' is set, draw() and record() first drop zero-area rectangles,
+	// merge same-color rectangles that exactly share an edge (within each run of
+	// consecutive same-color rectangles, so overlap order is preserved), and --
+	// in draw() only, since batches are drawn transformed -- cull rectangles
+	// entirely outside [-1,1]x[-1,1]:
+	bool optimize = false;
+	//rectangles before and after optimization in the last draw() or record():
+	struct OptimizeStats {
+		uint32_t rects_in = 0;
+		uint32_t rects_out = 0;
+	} optimize_stats;
+
+	//----- internals -----
+	//list of quads (four vertices each, drawn through a shared quad index buffer) to draw next call to "draw()":
+	std::vector< Vertex > vertices;
+	//vertices waiting in 'vertices' and all recorders:
+	size_t pending_vertices() const;
+	//move all waiting vertices to 'dst':
+	void gather(Vertex *dst);
+	//run the optimization described above on all waiting vertices:
+	void optimize_pending(bool cull);
+	//quads as opposite corners, used while optimizing:
+	struct Quad {
+		Vertex lo, hi;
+	};
+	std::vector< Quad > optimize_scratch;
+};
 
-struct Draw {
+typedef BasicDraw< PositionColorVertex > Draw;
+typedef BasicDraw< PaletteVertex > PaletteDraw;
+
+//set the colors PaletteDraw's indices refer to (at most 256; entries past the end of 'palette' are transparent black):
+void set_draw_palette(std::vector< glm::u8vec4 > const &palette);
+
+struct DrawInstanced {
 	//add rectangle [min.x,max.x] x [min.y,max.y] in color 'color':
 	void add_rectangle(glm::vec2 const &min, glm::vec2 const &max, glm::u8vec4 const &color);
 	//draw all rectangles added since last call to draw():
 	void draw();
 
 	//----- internals -----
-	//simple class for holding on to position + color attribute:
-	struct Vertex {
-		Vertex(glm::vec2 const &v_, glm::u8vec4 const &c_)
-			: v(v_), c(c_) {
+	//one record per rectangle; corners are generated from gl_VertexID:
+	struct Instance {
+		Instance(glm::vec2 const &min_, glm::vec2 const &max_, glm::u8vec4 const &c_)
+			: min(min_), max(max_), c(c_) {
 		}
-		glm::vec2 v;
+		glm::vec2 min;
+		glm::vec2 max;
 		glm::u8vec4 c;
 	};
-	static_assert(sizeof(Vertex) == 12, "Vertex is tightly packed.");
-	//list of triangles to draw next call to "draw()":
-	std::vector< Vertex > vertices;
+	static_assert(sizeof(Instance) == 20, "Instance is tightly packed.");
+	//list of rectangles to draw next call to "draw()":
+	std::vector< Instance > instances;
+};
+
+//counters for the streaming ring buffer shared by Draw and DrawInstanced:
+struct DrawStreamStats {
+	uint64_t bytes_streamed = 0; //bytes written into the ring
+	uint64_t wraps = 0; //times writing restarted at the beginning of the ring
+	uint64_t fence_waits = 0; //times a write had to block until the GPU was done with a region
+	uint64_t grows = 0; //times the ring was reallocated to fit a single upload
+	bool persistent = false; //the ring stays mapped (glBufferStorage) rather than being mapped per upload
+};
+extern DrawStreamStats draw_stream_stats;
+
+//running totals of what Draw, PaletteDraw and DrawInstanced have drawn:
+struct DrawCounters {
+	uint64_t draw_calls = 0;
+	uint64_t rectangles = 0;
+	uint64_t vertices = 0; //four per rectangle (instanced rectangles are expanded in the vertex shader)
+	uint64_t bytes_uploaded = 0; //vertex and instance data sent to the GPU, streamed or recorded into batches
+};
+extern DrawCounters draw_counters;
+
+//DrawContext owns the GL objects shared by every Draw, PaletteDraw and DrawInstanced:
+// shader programs, stream VAOs, the stream ring buffer and the quad index buffer.
+// Exactly one may exist at a time; Draw calls throw if there is none.
+// If 'program_cache_prefix' is non-empty (e.g. "some/dir/"), linked program
+// binaries are kept in files starting with it and reused by later runs.
+struct DrawContext {
+	DrawContext(std::string const &program_cache_prefix = "");
+	~DrawContext();
+	DrawContext(DrawContext const &) = delete;
+	DrawContext &operator=(DrawContext const &) = delete;
+
+	//draw through every path into a small offscreen framebuffer and wait for it to finish:
+	void warm_up();
+
+	//how setup went, for comparing cold (compiled) and warm (cached) starts:
+	uint32_t programs_cached = 0;
+	uint32_t programs_compiled = 0;
+	float setup_ms = 0.0f;
+
+	struct Internals;
+	Internals *internals = nullptr;
 };
@@ -0,0 +1,138 @@
+#include "FixedGame.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+//time to cover 'distance' at 'velocity', clamped to the representable range (a nearly-level
+// ball can take longer than 32767 seconds to reach a wall):
+static Fixed fixed_time(Fixed distance, Fixed velocity) {
+	int64_t t = (int64_t(distance) * 65536) / velocity;
+	t = std::max< int64_t >(std::numeric_limits< Fixed >::min(), std::min< int64_t >(t, std::numeric_limits< Fixed >::max()));
+	return Fixed(t);
+}
+
+//uniform in [0,1), from the game's own random stream:
+static Fixed game_random(FixedGameState &state) {
+	return Fixed(state.random.next() >> 16);
+}
+
+static void place_target(FixedGameState &state) {
+	state.target_y = fixed_mul(game_random(state), fixed(2.0) - state.target_size) + state.target_size / 2 - fixed(1.0);
+}
+
+static Fixed shrink_target(Fixed target_size) {
+	return std::max(fixed_mul(target_size, fixed(0.9)), fixed(0.05));
+}
+
+FixedGameState new_fixed_game(uint32_t seed, uint32_t stream, int score) {
+	FixedGameState state;
+	state.random = RandomStream(seed, stream);
+	state.score = score;
+	for (int i = 0; i < score; ++i) {
+		state.target_size = shrink_target(state.target_size);
+	}
+	place_target(state);
+	return state;
+}
+
+void step(FixedGameState &state, FixedGameInput const &input, Fixed dt) {
+	if (state.game_over) return;
+
+	state.paddle_y = input.paddle_y;
+	if (input.serve && !state.ball_moving) {
+		state.velocity_x = fixed(1.5);
+		state.velocity_y = fixed_mul(game_random(state), fixed(3.0)) - fixed(1.5);
+		state.ball_moving = true;
+	}
+
+	//swept surface by surface, as step() in Game.cpp:
+	Fixed const never = std::numeric_limits< Fixed >::max();
+	Fixed remaining = dt;
+	while (state.ball_moving) {
+		Fixed plane_x = 0, t_x = never;
+		if (state.velocity_x < 0) {
+			plane_x = (state.ball_x > fixed(-0.94) ? fixed(-0.94) : fixed(-1.0));
+			t_x = std::max(0, fixed_time(plane_x - state.ball_x, state.velocity_x));
+		} else if (state.velocity_x > 0) {
+			plane_x = (state.ball_x < fixed(0.94) ? fixed(0.94) : fixed(1.0));
+			t_x = std::max(0, fixed_time(plane_x - state.ball_x, state.velocity_x));
+		}
+		Fixed plane_y = 0, t_y = never;
+		if (state.velocity_y != 0) {
+			plane_y = (state.velocity_y < 0 ? fixed(-1.0) : fixed(1.0));
+			t_y = std::max(0, fixed_time(plane_y - state.ball_y, state.velocity_y));
+		}
+
+		Fixed t = std::min(t_x, t_y);
+		if (t > remaining) {
+			state.ball_x += fixed_mul(remaining, state.velocity_x);
+			state.ball_y += fixed_mul(remaining, state.velocity_y);
+			break;
+		}
+		state.ball_x += fixed_mul(t, state.velocity_x);
+		state.ball_y += fixed_mul(t, state.velocity_y);
+		remaining -= t;
+
+		if (t_y <= t_x) {
+			//wall collision (top/bottom)
+			state.ball_y = plane_y;
+			state.velocity_y = -state.velocity_y;
+		} else if (plane_x == fixed(-0.94)) {
+			//target collision
+			state.ball_x = plane_x;
+			Fixed target_offset = state.ball_y - state.target_y;
+			if (std::abs(target_offset) <= state.target_size / 2 + fixed(0.02)) {
+				if (++state.score == 99) {
+					state.game_over = true;
+				}
+				state.ball_x = state.ball_y = 0;
+				state.target_size = shrink_target(state.target_size);
+				place_target(state);
+				state.ball_moving = false;
+			}
+		} else if (plane_x == fixed(0.94)) {
+			//paddle collision
+			state.ball_x = plane_x;
+			Fixed paddle_offset = state.ball_y - state.paddle_y;
+			if (std::abs(paddle_offset) <= fixed(0.17)) {
+				state.velocity_x = -state.velocity_x;
+				state.velocity_y = paddle_offset * 10; //(1.5 * offset / 0.15)
+			}
+		} else if (plane_x == fixed(-1.0)) {
+			//wall collision (left)
+			state.ball_x = plane_x;
+			state.velocity_x = std::abs(state.velocity_x);
+		} else {
+			//missed the paddle
+			if (--state.lives == 0) {
+				state.game_over = true;
+			}
+			state.ball_x = state.ball_y = 0;
+			state.ball_moving = false;
+		}
+	}
+}
+
+GameState to_game_state(FixedGameState const &fixed_state) {
+	GameState state;
+	state.score = fixed_state.score;
+	state.lives = fixed_state.lives;
+	state.target_size = to_float(fixed_state.target_size);
+	state.target = glm::vec2(-1.0f, to_float(fixed_state.target_y));
+	state.paddle = glm::vec2(1.0f, to_float(fixed_state.paddle_y));
+	state.ball = glm::vec2(to_float(fixed_state.ball_x), to_float(fixed_state.ball_y));
+	state.ball_velocity = glm::vec2(to_float(fixed_state.velocity_x), to_float(fixed_state.velocity_y));
+	state.ball_moving = fixed_state.ball_moving;
+	state.game_over = fixed_state.game_over;
+	state.random = fixed_state.random;
+	return state;
+}
+
+Fixed computer_paddle(Fixed ball_y, Fixed paddle_y, Fixed aim_y, Fixed speed, Fixed dt) {
+	//(see computer_paddle() in Game.cpp; the offset is the aim velocity * 0.15 / 1.5)
+	Fixed offset = std::max(fixed(-0.15), std::min(fixed(0.15), fixed_mul(aim_y - ball_y, fixed(0.15 / 1.88))));
+	Fixed want = ball_y - offset;
+	Fixed step = fixed_mul(speed, dt);
+	return paddle_y + std::max(-step, std::min(step, want - paddle_y));
+}
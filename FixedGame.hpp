@@ -0,0 +1,78 @@
+#pragma once
+/*
+ * FixedGame is Tennis For One with Q16.16 fixed-point physics: every
+ * position, velocity, size and time is an int32_t counting 1/65536ths, and
+ * step() uses only integer arithmetic. Unlike the float rules in Game.cpp,
+ * results can't change with compiler flags, FMA contraction, vectorization,
+ * or platform, so a seed and input sequence replay bit-for-bit anywhere
+ * (e.g. in tennis_sim on any number of threads, or in './main --fixed-point').
+ *
+ * The rules are the same as step() in Game.cpp, rounded to 1/65536: e.g. the
+ * 240 Hz step is 273/65536 s (0.02% slow).
+ *
+ * Example:
+ *   FixedGameState state = new_fixed_game(seed);
+ *   FixedGameInput input;
+ *   input.paddle_y = to_fixed(0.1f);
+ *   input.serve = true;
+ *   step(state, input, fixed(1.0 / 240.0));
+ *   GameState for_drawing = to_game_state(state);
+ */
+
+#include "Game.hpp"
+#include "Random.hpp"
+
+#include <cstdint>
+#include <cmath>
+
+typedef int32_t Fixed; //Q16.16
+
+//compile-time constants (rounded to nearest):
+constexpr Fixed fixed(double value) {
+	return Fixed(value * 65536.0 + (value < 0.0 ? -0.5 : 0.5));
+}
+//run-time conversions (e.g. of mouse input):
+inline Fixed to_fixed(float value) {
+	return Fixed(std::lround(double(value) * 65536.0));
+}
+inline float to_float(Fixed value) {
+	return value / 65536.0f;
+}
+
+//(right shifts of negative values are arithmetic on every compiler we build with)
+inline Fixed fixed_mul(Fixed a, Fixed b) {
+	return Fixed((int64_t(a) * int64_t(b)) >> 16);
+}
+
+struct FixedGameState {
+	int score = 0;
+	int lives = 3;
+
+	Fixed target_size = fixed(1.2);
+	Fixed target_y = 0;
+	Fixed paddle_y = 0;
+
+	Fixed ball_x = 0, ball_y = 0;
+	Fixed velocity_x = 0, velocity_y = 0;
+	bool ball_moving = false;
+	bool game_over = false;
+
+	RandomStream random;
+};
+
+struct FixedGameInput {
+	Fixed paddle_y = 0;
+	bool serve = false;
+};
+
+//as new_game() in Game.hpp:
+FixedGameState new_fixed_game(uint32_t seed, uint32_t stream = 0, int score = 0);
+
+//as step() in Game.hpp, with 'dt' in Q16.16 seconds:
+void step(FixedGameState &state, FixedGameInput const &input, Fixed dt);
+
+//the state as floats, for drawing:
+GameState to_game_state(FixedGameState const &state);
+
+//as computer_paddle() in Game.hpp:
+Fixed computer_paddle(Fixed ball_y, Fixed paddle_y, Fixed aim_y, Fixed speed, Fixed dt);
@@ -0,0 +1,229 @@
+#include "Game.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//uniform in [0,1], from the game's own random stream:
+static float game_random(GameState &state) {
+	return state.random.next_float();
+}
+
+//pick a new target position for the current target size:
+static void place_target(GameState &state) {
+	float target_y = game_random(state) * (2.0f - state.target_size) + state.target_size / 2.0f - 1.0f;
+	state.target = glm::vec2(-1.0f, target_y);
+}
+
+//each point shrinks the target by 10%, down to a minimum size:
+static float shrink_target(float target_size) {
+	return std::max(target_size * 0.9f, 0.05f);
+}
+
+float target_size_at(int score) {
+	float target_size = GameState().target_size;
+	for (int i = 0; i < score; ++i) {
+		target_size = shrink_target(target_size);
+	}
+	return target_size;
+}
+
+GameState new_game(uint32_t seed, uint32_t stream, int score) {
+	GameState state;
+	state.random = RandomStream(seed, stream);
+	state.score = score;
+	state.target_size = target_size_at(score);
+	place_target(state);
+	return state;
+}
+
+void serve(GameState &state) {
+	state.ball_velocity = glm::vec2(1.5f, game_random(state) * 3.0f - 1.5f);
+	state.ball_moving = true;
+}
+
+BallContact next_contact(GameState const &state) {
+	glm::vec2 const &ball = state.ball;
+	glm::vec2 const &ball_velocity = state.ball_velocity;
+
+	//the next surface along each axis and the time until the ball reaches it:
+	float const never = std::numeric_limits< float >::infinity();
+	float plane_x = 0.0f, t_x = never;
+	if (ball_velocity.x < 0.0f) {
+		plane_x = (ball.x > -0.94f ? -0.94f : -1.0f); //target face, then left wall
+		t_x = std::max(0.0f, (plane_x - ball.x) / ball_velocity.x);
+	} else if (ball_velocity.x > 0.0f) {
+		plane_x = (ball.x < 0.94f ? 0.94f : 1.0f); //paddle face, then the edge behind it
+		t_x = std::max(0.0f, (plane_x - ball.x) / ball_velocity.x);
+	}
+	float plane_y = 0.0f, t_y = never;
+	if (ball_velocity.y != 0.0f) {
+		plane_y = (ball_velocity.y < 0.0f ? -1.0f : 1.0f);
+		t_y = std::max(0.0f, (plane_y - ball.y) / ball_velocity.y);
+	}
+
+	BallContact contact;
+	if (t_y == never && t_x == never) {
+		//(not moving)
+	} else if (t_y <= t_x) {
+		contact.surface = BallContact::Wall;
+		contact.time = t_y;
+		contact.plane = plane_y;
+	} else {
+		contact.surface = (plane_x == -0.94f ? BallContact::Target
+		                 : plane_x == 0.94f ? BallContact::Paddle
+		                 : plane_x == -1.0f ? BallContact::LeftWall
+		                 : BallContact::Behind);
+		contact.time = t_x;
+		contact.plane = plane_x;
+	}
+	return contact;
+}
+
+void resolve_contact(GameState &state, BallContact const &contact) {
+	glm::vec2 &ball = state.ball;
+	glm::vec2 &ball_velocity = state.ball_velocity;
+
+	if (contact.surface == BallContact::Wall) {
+		//wall collision (top/bottom)
+		ball.y = contact.plane;
+		ball_velocity.y = -ball_velocity.y;
+	} else if (contact.surface == BallContact::Target) {
+		//target collision
+		ball.x = contact.plane;
+		float target_offset = ball.y - state.target.y;
+		if (std::abs(target_offset) <= (state.target_size / 2.0f + 0.02f)) {
+			if (++state.score == 99) {
+				state.game_over = true;
+			}
+			ball = glm::vec2(0.0f, 0.0f);
+			state.target_size = shrink_target(state.target_size);
+			place_target(state);
+			state.ball_moving = false;
+		}
+	} else if (contact.surface == BallContact::Paddle) {
+		//paddle collision
+		ball.x = contact.plane;
+		float paddle_offset = ball.y - state.paddle.y;
+		if (std::abs(paddle_offset) <= 0.17f) {
+			ball_velocity.x = -ball_velocity.x;
+			ball_velocity.y = 1.5f * paddle_offset / 0.15f;
+		}
+	} else if (contact.surface == BallContact::LeftWall) {
+		//wall collision (left)
+		ball.x = contact.plane;
+		ball_velocity.x = std::abs(ball_velocity.x);
+	} else if (contact.surface == BallContact::Behind) {
+		//missed the paddle
+		if (--state.lives == 0) {
+			state.game_over = true;
+		}
+		ball = glm::vec2(0.0f, 0.0f);
+		state.ball_moving = false;
+	}
+}
+
+float advance_to_contact(GameState &state) {
+	BallContact contact = next_contact(state);
+	if (contact.surface == BallContact::None) return 0.0f;
+	state.ball += contact.time * state.ball_velocity;
+	resolve_contact(state, contact);
+	return contact.time;
+}
+
+void step(GameState &state, GameInput const &input, float dt) {
+	if (state.game_over) return;
+
+	state.paddle.y = input.paddle_y;
+	if (input.serve && !state.ball_moving) {
+		serve(state);
+	}
+
+	//move the ball through the step surface by surface, stopping exactly where it reaches each one
+	// (earliest first), so a fast ball or a long step can't pass through the paddle or target.
+	// This always finishes: each contact sends the ball away from its surface (or ends the point),
+	// so only a corner can give a second contact with no time between:
+	float remaining = dt;
+	while (state.ball_moving) {
+		BallContact contact = next_contact(state);
+		if (contact.time > remaining) {
+			state.ball += remaining * state.ball_velocity;
+			break;
+		}
+		state.ball += contact.time * state.ball_velocity;
+		remaining -= contact.time;
+		resolve_contact(state, contact);
+	}
+}
+
+float computer_paddle(float ball_y, float paddle_y, float aim_y, float speed, float dt) {
+	//returns leave at 1.5 units/s horizontally, taking 1.88 / 1.5 seconds to reach the target,
+	// and with vertical speed 1.5 * offset / 0.15 (see step()):
+	float aim_velocity = (aim_y - ball_y) / (1.88f / 1.5f);
+	float offset = std::max(-0.15f, std::min(0.15f, aim_velocity * 0.15f / 1.5f));
+	float want = ball_y - offset;
+	float move = std::max(-speed * dt, std::min(speed * dt, want - paddle_y));
+	return paddle_y + move;
+}
+
+float computer_paddle_steps(float ball_y, float ball_velocity_y, float paddle_y, float aim_y, float speed, float dt, uint64_t steps) {
+	//computer_paddle() chases want = ball_y - offset, with offset = clamp(c * (aim_y - ball_y), +-0.15).
+	// The ball's y is linear in the step, so 'want' is too, within each of the three pieces
+	// where the clamp is below, between or above its limits:
+	double const c = 0.15 / 1.5 / (1.88 / 1.5);
+	double const reach = 0.15 / c; //the clamp is between its limits for |aim_y - ball_y| < reach
+	double const limit = speed * double(dt); //furthest the paddle moves in a step
+	double const b0 = ball_y, db = double(ball_velocity_y) * dt; //ball y at step k is b0 + k * db
+	auto want_at = [&](double b, int piece) -> double {
+		if (piece < 0) return b - 0.15; //ball well below the aim point
+		if (piece > 0) return b + 0.15; //ball well above it
+		return b - c * (aim_y - b);
+	};
+	auto piece_of = [&](double b) -> int {
+		return (aim_y - b >= reach ? -1 : (b - aim_y >= reach ? 1 : 0));
+	};
+	//first step at or after 'k' at which the ball is past 'edge' (moving away from piece 'piece'), or 'steps':
+	auto piece_end = [&](uint64_t k, int piece) -> uint64_t {
+		double edge;
+		if (db > 0.0 && piece < 1) edge = aim_y + (piece < 0 ? -reach : reach);
+		else if (db < 0.0 && piece > -1) edge = aim_y + (piece > 0 ? reach : -reach);
+		else return steps;
+		double end = std::ceil((edge - b0) / db);
+		if (!(end < double(steps))) return steps;
+		return std::max(k + 1, uint64_t(std::max(end, 0.0)));
+	};
+
+	double p = paddle_y;
+	uint64_t k = 0;
+	while (k < steps) {
+		int piece = piece_of(b0 + k * db);
+		uint64_t end = piece_end(k, piece);
+		double const m = (piece == 0 ? (1.0 + c) * db : db); //change in 'want' per step
+		//within the piece, each step either closes the gap at a constant rate, or catches 'want'
+		// (after which the paddle sits one step behind it, unless 'want' outruns it):
+		while (k < end) {
+			double gap = want_at(b0 + k * db, piece) - p;
+			if (std::abs(gap) <= limit) {
+				if (std::abs(m) <= limit) {
+					//caught, and it can keep up for the rest of the piece:
+					p = want_at(b0 + (end - 1) * db, piece);
+					k = end;
+				} else {
+					p += gap;
+					k += 1;
+				}
+			} else {
+				double sign = (gap > 0.0 ? 1.0 : -1.0);
+				double closing = limit - sign * m; //how much the gap shrinks each step
+				uint64_t run = end - k;
+				if (closing > 0.0) {
+					//steps until the gap is within reach (or has changed sign):
+					run = std::min(run, uint64_t(std::max(1.0, std::ceil((sign * gap - limit) / closing))));
+				}
+				p += sign * limit * run;
+				k += run;
+			}
+		}
+	}
+	return float(p);
+}
@@ -0,0 +1,100 @@
+#pragma once
+/*
+ * Game holds the "Tennis For One" rules with no dependency on SDL or OpenGL,
+ * so the same code runs in the game (main.cpp) and in headless tools
+ * (tennis_sim.cpp).
+ *
+ * All game state is in the plain-data GameState; step() advances it by one
+ * fixed timestep given the player's input. step() uses no global state
+ * (randomness comes from a counter-based stream stored in GameState, see
+ * Random.hpp), so the same seed, stream, and inputs always produce the same
+ * game, and games on different threads never share a generator.
+ *
+ * Example:
+ *   GameState state = new_game(seed, game_index);
+ *   GameInput input;
+ *   input.paddle_y = 0.1f;
+ *   input.serve = true;
+ *   step(state, input, 1.0f / 240.0f);
+ */
+
+#include "Random.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+
+struct GameState {
+	int score = 0;
+	int lives = 3;
+
+	//the target is a vertical bar on the left edge, centered on target.y:
+	float target_size = 1.2f;
+	glm::vec2 target = glm::vec2(-1.0f, 0.0f);
+	//the paddle is a 0.3-tall bar on the right edge, centered on paddle.y:
+	glm::vec2 paddle = glm::vec2(1.0f, 0.0f);
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(0.0f, 0.0f);
+	bool ball_moving = false; //false until served, and again after each point
+	bool game_over = false;
+
+	RandomStream random; //draws for target placement and serves
+};
+
+//what the player does during a step:
+struct GameInput {
+	float paddle_y = 0.0f; //where the player wants the paddle
+	bool serve = false; //launch the ball, if it isn't moving
+};
+
+//a fresh game using random stream 'stream' of 'seed' (so games with the same
+// seed and different streams are independent); 'score' starts the game
+// part-way through (with the target already shrunk for that many points):
+GameState new_game(uint32_t seed, uint32_t stream = 0, int score = 0);
+
+//advance 'state' by 'dt' seconds; the ball is swept through the step, contact
+// by contact until all of 'dt' is used, so any 'dt' is handled correctly (larger
+// ones just sample the paddle less often, and take longer):
+void step(GameState &state, GameInput const &input, float dt);
+
+//launch the ball (as step() does when 'serve' is set and the ball isn't moving):
+void serve(GameState &state);
+
+//Between contacts the ball moves in a straight line, so the next one can be
+// found exactly. step() is built from these; an event-driven simulation can
+// use them to jump from contact to contact without stepping:
+struct BallContact {
+	enum Surface : uint8_t {
+		None, //ball not moving
+		Wall, //top or bottom wall
+		Target, //target face (x = -0.94); scores if the target is there
+		LeftWall, //left edge, above or below the target
+		Paddle, //paddle face (x = 0.94); returns the ball if the paddle is there
+		Behind, //right edge: the paddle was missed
+	} surface = None;
+	float time = std::numeric_limits< float >::infinity(); //seconds until the contact
+	float plane = 0.0f; //x (or, for Wall, y) of the surface
+};
+
+//the ball's next contact, if nothing changes before then:
+BallContact next_contact(GameState const &state);
+//apply 'contact' to a ball that has just reached it, using the current paddle position:
+void resolve_contact(GameState &state, BallContact const &contact);
+//move the ball straight to its next contact and resolve it; returns the time taken:
+float advance_to_contact(GameState &state);
+
+//target size after 'score' points:
+float target_size_at(int score);
+
+//A simple computer player, used by the headless tools: the paddle y for this
+// step when moving at most 'speed' units per second toward where hitting the
+// ball would send it (ignoring wall bounces) at 'aim_y':
+float computer_paddle(float ball_y, float paddle_y, float aim_y, float speed, float dt);
+
+//The paddle y after 'steps' computer_paddle() calls 'dt' apart while the ball moves in a straight
+// line, the first call seeing the ball at 'ball_y' and each later one 'dt' * 'ball_velocity_y'
+// further on. Computed in closed form, in a few operations however many steps there are (so it
+// agrees with calling computer_paddle() in a loop up to float rounding):
+float computer_paddle_steps(float ball_y, float ball_velocity_y, float paddle_y, float aim_y, float speed, float dt, uint64_t steps);
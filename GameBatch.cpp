@@ -0,0 +1,242 @@
+#include "GameBatch.hpp"
+
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GAME_BATCH_SSE2
+#endif
+
+//games are stepped four at a time, so arrays are padded to a multiple of four:
+static const uint32_t Lanes = 4;
+
+GameBatch::GameBatch(uint32_t count_, uint32_t seed) : count(count_), padded((count_ + Lanes - 1) / Lanes * Lanes) {
+	input_paddle_y.assign(padded, 0.0f);
+	input_serve.assign(padded, 0);
+	ball_x.assign(padded, 0.0f);
+	ball_y.assign(padded, 0.0f);
+	velocity_x.assign(padded, 0.0f);
+	velocity_y.assign(padded, 0.0f);
+	paddle_y.assign(padded, 0.0f);
+	target_y.assign(padded, 0.0f);
+	target_size.assign(padded, 0.0f);
+	score.assign(padded, 0);
+	lives.assign(padded, 0);
+	ball_moving.assign(padded, 0);
+	game_over.assign(padded, ~0);
+	random_seed.assign(padded, 0);
+	random_stream.assign(padded, 0);
+	random_position.assign(padded, 0);
+	for (uint32_t i = 0; i < count; ++i) {
+		set(i, new_game(seed, i));
+	}
+}
+
+GameState GameBatch::get(uint32_t i) const {
+	GameState state;
+	state.score = score[i];
+	state.lives = lives[i];
+	state.target_size = target_size[i];
+	state.target = glm::vec2(-1.0f, target_y[i]);
+	state.paddle = glm::vec2(1.0f, paddle_y[i]);
+	state.ball = glm::vec2(ball_x[i], ball_y[i]);
+	state.ball_velocity = glm::vec2(velocity_x[i], velocity_y[i]);
+	state.ball_moving = (ball_moving[i] != 0);
+	state.game_over = (game_over[i] != 0);
+	state.random = RandomStream(random_seed[i], random_stream[i], random_position[i]);
+	return state;
+}
+
+void GameBatch::set(uint32_t i, GameState const &state) {
+	score[i] = state.score;
+	lives[i] = state.lives;
+	target_size[i] = state.target_size;
+	target_y[i] = state.target.y;
+	paddle_y[i] = state.paddle.y;
+	ball_x[i] = state.ball.x;
+	ball_y[i] = state.ball.y;
+	velocity_x[i] = state.ball_velocity.x;
+	velocity_y[i] = state.ball_velocity.y;
+	ball_moving[i] = (state.ball_moving ? ~0 : 0);
+	game_over[i] = (state.game_over ? ~0 : 0);
+	random_seed[i] = state.random.seed;
+	random_stream[i] = state.random.stream;
+	random_position[i] = uint32_t(state.random.position);
+}
+
+void GameBatch::step_reference(float dt) {
+	for (uint32_t i = 0; i < count; ++i) {
+		GameState state = get(i);
+		GameInput input;
+		input.paddle_y = input_paddle_y[i];
+		input.serve = (input_serve[i] != 0);
+		::step(state, input, dt);
+		set(i, state);
+	}
+}
+
+#ifdef GAME_BATCH_SSE2
+
+//mask ? a : b, for floats and ints:
+static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+//four copies of game_random() from Game.cpp (one Philox block per lane), advancing only the lanes in 'mask':
+static inline __m128 random_where(__m128i mask, __m128i const key[2], __m128i &position) {
+	//(draws are rare -- serves and points -- so skip the work when no lane wants one)
+	if (_mm_movemask_epi8(mask) == 0) return _mm_setzero_ps();
+	__m128i c[4] = { _mm_srli_epi32(position, 2), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+	philox4x32_sse2(c, key);
+	//draw 'position' is word position % 4 of the block:
+	__m128i word = _mm_and_si128(position, _mm_set1_epi32(3));
+	__m128i x = select(_mm_cmpeq_epi32(word, _mm_setzero_si128()), c[0],
+		select(_mm_cmpeq_epi32(word, _mm_set1_epi32(1)), c[1],
+		select(_mm_cmpeq_epi32(word, _mm_set1_epi32(2)), c[2], c[3])));
+	position = _mm_add_epi32(position, _mm_and_si128(mask, _mm_set1_epi32(1)));
+	return _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), _mm_set1_ps(float(0xffffff)));
+}
+
+void GameBatch::step(float dt) {
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const never = _mm_set1_ps(std::numeric_limits< float >::infinity());
+	__m128 const sign = _mm_set1_ps(-0.0f);
+	__m128i const ones = _mm_set1_epi32(1);
+
+	for (uint32_t i = 0; i < padded; i += Lanes) {
+		__m128 bx = _mm_loadu_ps(&ball_x[i]);
+		__m128 by = _mm_loadu_ps(&ball_y[i]);
+		__m128 vx = _mm_loadu_ps(&velocity_x[i]);
+		__m128 vy = _mm_loadu_ps(&velocity_y[i]);
+		__m128 py = _mm_loadu_ps(&paddle_y[i]);
+		__m128 ty = _mm_loadu_ps(&target_y[i]);
+		__m128 ts = _mm_loadu_ps(&target_size[i]);
+		__m128i sc = _mm_loadu_si128(reinterpret_cast< __m128i const * >(&score[i]));
+		__m128i li = _mm_loadu_si128(reinterpret_cast< __m128i const * >(&lives[i]));
+		__m128i moving = _mm_loadu_si128(reinterpret_cast< __m128i const * >(&ball_moving[i]));
+		__m128i over = _mm_loadu_si128(reinterpret_cast< __m128i const * >(&game_over[i]));
+		__m128i const key[2] = {
+			_mm_loadu_si128(reinterpret_cast< __m128i const * >(&random_seed[i])),
+			_mm_loadu_si128(reinterpret_cast< __m128i const * >(&random_stream[i])),
+		};
+		__m128i position = _mm_loadu_si128(reinterpret_cast< __m128i const * >(&random_position[i]));
+
+		//input (ignored once a game is over):
+		__m128i playing = _mm_xor_si128(over, _mm_set1_epi32(~0));
+		py = select(_mm_castsi128_ps(playing), _mm_loadu_ps(&input_paddle_y[i]), py);
+		__m128i serve = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast< __m128i const * >(&input_serve[i])), _mm_setzero_si128()), playing);
+		serve = _mm_andnot_si128(moving, serve);
+		{
+			__m128 r = random_where(serve, key, position);
+			__m128 serve_f = _mm_castsi128_ps(serve);
+			vx = select(serve_f, _mm_set1_ps(1.5f), vx);
+			vy = select(serve_f, _mm_sub_ps(_mm_mul_ps(r, _mm_set1_ps(3.0f)), _mm_set1_ps(1.5f)), vy);
+			moving = _mm_or_si128(moving, serve);
+		}
+
+		//sweep the ball surface by surface, as in step(); lanes drop out as they finish:
+		__m128 remaining = _mm_set1_ps(dt);
+		__m128i going = _mm_and_si128(moving, playing);
+		while (true) {
+			__m128i live = _mm_and_si128(going, moving);
+			if (_mm_movemask_epi8(live) == 0) break;
+			__m128 live_f = _mm_castsi128_ps(live);
+
+			//next surface along x: target face then left wall, or paddle face then the edge behind it:
+			__m128 left = _mm_cmplt_ps(vx, zero);
+			__m128 right = _mm_cmpgt_ps(vx, zero);
+			__m128 plane_x = select(left,
+				select(_mm_cmpgt_ps(bx, _mm_set1_ps(-0.94f)), _mm_set1_ps(-0.94f), _mm_set1_ps(-1.0f)),
+				select(right, select(_mm_cmplt_ps(bx, _mm_set1_ps(0.94f)), _mm_set1_ps(0.94f), _mm_set1_ps(1.0f)), zero)
+			);
+			__m128 t_x = select(_mm_or_ps(left, right), _mm_max_ps(_mm_div_ps(_mm_sub_ps(plane_x, bx), vx), zero), never);
+			//next surface along y:
+			__m128 up_or_down = _mm_cmpneq_ps(vy, zero);
+			__m128 plane_y = select(_mm_cmplt_ps(vy, zero), _mm_set1_ps(-1.0f), _mm_set1_ps(1.0f));
+			plane_y = _mm_and_ps(up_or_down, plane_y);
+			__m128 t_y = select(up_or_down, _mm_max_ps(_mm_div_ps(_mm_sub_ps(plane_y, by), vy), zero), never);
+
+			__m128 t = _mm_min_ps(t_y, t_x);
+			__m128 finish = _mm_and_ps(live_f, _mm_cmpgt_ps(t, remaining));
+			__m128 contact = _mm_andnot_ps(finish, live_f);
+			//finishing lanes move by 'remaining', contacting lanes by 't':
+			__m128 move = select(finish, remaining, _mm_and_ps(contact, t));
+			bx = select(live_f, _mm_add_ps(bx, _mm_mul_ps(move, vx)), bx);
+			by = select(live_f, _mm_add_ps(by, _mm_mul_ps(move, vy)), by);
+			remaining = select(contact, _mm_sub_ps(remaining, t), remaining);
+			going = _mm_andnot_si128(_mm_castps_si128(finish), going);
+			//(usually nothing is hit during a step)
+			if (_mm_movemask_ps(contact) == 0) break;
+
+			__m128 wall_y = _mm_and_ps(contact, _mm_cmple_ps(t_y, t_x));
+			__m128 wall_x = _mm_andnot_ps(wall_y, contact);
+			__m128 at_target = _mm_and_ps(wall_x, _mm_cmpeq_ps(plane_x, _mm_set1_ps(-0.94f)));
+			__m128 at_paddle = _mm_and_ps(wall_x, _mm_cmpeq_ps(plane_x, _mm_set1_ps(0.94f)));
+			__m128 at_left = _mm_and_ps(wall_x, _mm_cmpeq_ps(plane_x, _mm_set1_ps(-1.0f)));
+			__m128 at_right = _mm_and_ps(wall_x, _mm_cmpeq_ps(plane_x, _mm_set1_ps(1.0f)));
+
+			//wall collision (top/bottom):
+			by = select(wall_y, plane_y, by);
+			vy = select(wall_y, _mm_xor_ps(vy, sign), vy);
+
+			bx = select(wall_x, plane_x, bx);
+
+			//target collision:
+			__m128 target_offset = _mm_andnot_ps(sign, _mm_sub_ps(by, ty));
+			__m128 scored = _mm_and_ps(at_target, _mm_cmple_ps(target_offset, _mm_add_ps(_mm_div_ps(ts, _mm_set1_ps(2.0f)), _mm_set1_ps(0.02f))));
+			__m128i scored_i = _mm_castps_si128(scored);
+			sc = _mm_add_epi32(sc, _mm_and_si128(scored_i, ones));
+			over = _mm_or_si128(over, _mm_and_si128(scored_i, _mm_cmpeq_epi32(sc, _mm_set1_epi32(99))));
+			ts = select(scored, _mm_max_ps(_mm_mul_ps(ts, _mm_set1_ps(0.9f)), _mm_set1_ps(0.05f)), ts);
+			{
+				__m128 r = random_where(scored_i, key, position);
+				__m128 placed = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(2.0f), ts)), _mm_div_ps(ts, _mm_set1_ps(2.0f))), _mm_set1_ps(1.0f));
+				ty = select(scored, placed, ty);
+			}
+
+			//paddle collision:
+			__m128 paddle_offset = _mm_sub_ps(by, py);
+			__m128 returned = _mm_and_ps(at_paddle, _mm_cmple_ps(_mm_andnot_ps(sign, paddle_offset), _mm_set1_ps(0.17f)));
+			vx = select(returned, _mm_xor_ps(vx, sign), vx);
+			vy = select(returned, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(1.5f), paddle_offset), _mm_set1_ps(0.15f)), vy);
+
+			//wall collision (left):
+			vx = select(at_left, _mm_andnot_ps(sign, vx), vx);
+
+			//missed the paddle:
+			__m128i missed_i = _mm_castps_si128(at_right);
+			li = _mm_sub_epi32(li, _mm_and_si128(missed_i, ones));
+			over = _mm_or_si128(over, _mm_and_si128(missed_i, _mm_cmpeq_epi32(li, _mm_setzero_si128())));
+
+			//either way the point is over, so the ball is reset:
+			__m128 reset = _mm_or_ps(scored, at_right);
+			bx = _mm_andnot_ps(reset, bx);
+			by = _mm_andnot_ps(reset, by);
+			moving = _mm_andnot_si128(_mm_castps_si128(reset), moving);
+		}
+
+		_mm_storeu_ps(&ball_x[i], bx);
+		_mm_storeu_ps(&ball_y[i], by);
+		_mm_storeu_ps(&velocity_x[i], vx);
+		_mm_storeu_ps(&velocity_y[i], vy);
+		_mm_storeu_ps(&paddle_y[i], py);
+		_mm_storeu_ps(&target_y[i], ty);
+		_mm_storeu_ps(&target_size[i], ts);
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(&score[i]), sc);
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(&lives[i]), li);
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(&ball_moving[i]), moving);
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(&game_over[i]), over);
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(&random_position[i]), position);
+	}
+}
+
+#else //no SSE2: fall back to stepping each game on its own
+
+void GameBatch::step(float dt) {
+	step_reference(dt);
+}
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+/*
+ * GameBatch steps many games of Tennis For One at once. Each field of
+ * GameState is stored as its own array (structure-of-arrays), so step() can
+ * advance four games per SSE instruction, with collisions handled by masks
+ * rather than branches. It follows the same rules, in the same order and
+ * with the same float operations, as step() in Game.cpp, so each game in the
+ * batch evolves bit-for-bit like a GameState stepped on its own
+ * (step_reference() does exactly that, for checking).
+ *
+ * Example:
+ *   GameBatch batch(1000, seed); //games use streams 0, 1, ... of seed
+ *   //...each step, fill batch.input_paddle_y[i] and batch.input_serve[i], then:
+ *   batch.step(1.0f / 240.0f);
+ */
+
+#include "Game.hpp"
+
+#include <vector>
+#include <cstdint>
+
+struct GameBatch {
+	//'count' new games, game i using stream i of 'seed' (as new_game(seed, i)):
+	GameBatch(uint32_t count, uint32_t seed);
+
+	//advance every game by 'dt' with the inputs below:
+	void step(float dt);
+	//same, one game at a time through ::step():
+	void step_reference(float dt);
+
+	//copy game 'i' to or from a GameState:
+	GameState get(uint32_t i) const;
+	void set(uint32_t i, GameState const &state);
+
+	uint32_t count; //games in the batch
+	uint32_t padded; //array length; count rounded up to the SIMD width (extra games are over)
+
+	//per-game inputs for the next step:
+	std::vector< float > input_paddle_y;
+	std::vector< int32_t > input_serve; //nonzero to serve
+
+	//per-game state (see GameState); flags are 0 or ~0 so they work as SIMD masks:
+	std::vector< float > ball_x, ball_y;
+	std::vector< float > velocity_x, velocity_y;
+	std::vector< float > paddle_y;
+	std::vector< float > target_y, target_size;
+	std::vector< int32_t > score, lives;
+	std::vector< int32_t > ball_moving, game_over;
+	std::vector< uint32_t > random_seed, random_stream;
+	std::vector< uint32_t > random_position; //(a game makes far fewer than 2^32 draws, so only the low half is kept)
+};
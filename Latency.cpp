@@ -0,0 +1,61 @@
+#include "Latency.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+constexpr float LatencyHistogram::BinMs;
+
+void LatencyHistogram::add(float ms) {
+	ms = std::max(ms, 0.0f); //(event and clock times are only good to about a millisecond)
+	uint32_t bin = std::min(Bins - 1, uint32_t(ms / BinMs));
+	bins[bin] += 1;
+	count += 1;
+	total_ms += ms;
+	max_ms = std::max(max_ms, ms);
+}
+
+float LatencyHistogram::percentile(float p) const {
+	if (count == 0) return 0.0f;
+	uint64_t want = std::max< uint64_t >(1, uint64_t(p * count + 0.5));
+	uint64_t seen = 0;
+	for (uint32_t b = 0; b < Bins; ++b) {
+		seen += bins[b];
+		if (seen >= want) return (b + 1 == Bins ? max_ms : std::min(max_ms, (b + 1) * BinMs));
+	}
+	return max_ms;
+}
+
+void LatencyHistogram::clear() {
+	*this = LatencyHistogram();
+}
+
+const char *LatencyTelemetry::stage_name(Stage stage) {
+	switch (stage) {
+		case Update: return "update";
+		case Submit: return "submit";
+		case Swap: return "swap";
+		case GPU: return "gpu";
+		default: return "?";
+	}
+}
+
+void LatencyTelemetry::print(std::ostream &out) const {
+	out << "Input latency (ms after the mouse event):" << std::endl;
+	out << "  stage      count     mean      p50      p95      p99      max" << std::endl;
+	std::ios::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+	out << std::fixed << std::setprecision(2);
+	for (uint32_t s = 0; s < StageCount; ++s) {
+		LatencyHistogram const &h = stages[s];
+		out << "  " << std::left << std::setw(6) << stage_name(Stage(s)) << std::right
+		    << std::setw(10) << h.count
+		    << std::setw(9) << (h.count ? h.total_ms / h.count : 0.0)
+		    << std::setw(9) << h.percentile(0.50f)
+		    << std::setw(9) << h.percentile(0.95f)
+		    << std::setw(9) << h.percentile(0.99f)
+		    << std::setw(9) << h.max_ms << std::endl;
+	}
+	out.precision(precision);
+	out.flags(flags);
+}
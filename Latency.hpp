@@ -0,0 +1,55 @@
+#pragma once
+/*
+ * Latency keeps histograms of how long input takes to reach the screen,
+ * split by stage of the frame loop. main.cpp stamps each mouse motion with
+ * its SDL event time and records how old it is when the simulation first
+ * uses it (Update), when that frame's draws have been submitted (Submit),
+ * when SDL_GL_SwapWindow returns (Swap), and when a fence placed after the
+ * swap shows the GPU has finished the frame (GPU, seen when the fence is next
+ * polled, so it may read up to a frame late).
+ *
+ * Histograms have fixed 0.1ms bins, so recording never allocates; percentiles
+ * are read from them at any time, and print() writes a table (main does this
+ * at exit).
+ *
+ * Example:
+ *   LatencyTelemetry latency;
+ *   latency.add(LatencyTelemetry::Swap, now_ms - event_ms);
+ *   float p99 = latency.stages[LatencyTelemetry::Swap].percentile(0.99);
+ *   latency.print(std::cout);
+ */
+
+#include <cstdint>
+#include <iosfwd>
+
+struct LatencyHistogram {
+	static const uint32_t Bins = 2500; //0.1ms each, so up to 250ms; longer samples go in the last bin
+	static constexpr float BinMs = 0.1f;
+
+	void add(float ms);
+	//smallest latency with at least fraction 'p' of samples at or below it (upper edge of its bin):
+	float percentile(float p) const;
+	void clear();
+
+	uint64_t count = 0;
+	float max_ms = 0.0f;
+	double total_ms = 0.0;
+	uint32_t bins[Bins] = { };
+};
+
+struct LatencyTelemetry {
+	enum Stage {
+		Update, //input first used by a simulation step
+		Submit, //that frame's draws submitted
+		Swap, //SDL_GL_SwapWindow returned
+		GPU, //frame finished on the GPU
+		StageCount
+	};
+	static const char *stage_name(Stage stage);
+
+	void add(Stage stage, float ms) { stages[stage].add(ms); }
+	//count, mean, p50, p95, p99, and max for each stage:
+	void print(std::ostream &out) const;
+
+	LatencyHistogram stages[StageCount];
+};
@@ -0,0 +1,150 @@
+#include "Pacing.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+#if defined(_WIN32) || defined(__APPLE__)
+//(no clock_nanosleep here; fall back on the standard library's steady clock and sleep)
+#include <chrono>
+#include <thread>
+#else
+#include <time.h>
+#endif
+
+const uint32_t VsyncPredictor::History;
+const uint32_t FramePacer::JitterBins;
+constexpr double FramePacer::JitterBinMs;
+
+void VsyncPredictor::swapped(double ms) {
+	if (swaps > 0) {
+		double interval = ms - last_swap_ms;
+		if (ready()) {
+			//a long interval is one or more missed vblanks; keep it out of the period estimate:
+			double period = period_ms();
+			if (interval > 1.5 * period) {
+				missed += uint64_t(std::floor(interval / period + 0.5)) - 1;
+				interval = -1.0;
+			}
+		}
+		if (interval > 0.0) {
+			intervals[next_interval] = interval;
+			next_interval = (next_interval + 1) % History;
+			interval_count = std::min(interval_count + 1, History);
+		}
+	}
+	last_swap_ms = ms;
+	swaps += 1;
+}
+
+double VsyncPredictor::period_ms() const {
+	if (interval_count == 0) return 0.0;
+	double sorted[History];
+	std::copy(intervals, intervals + interval_count, sorted);
+	std::nth_element(sorted, sorted + interval_count / 2, sorted + interval_count);
+	return sorted[interval_count / 2];
+}
+
+double VsyncPredictor::next_vsync_ms(double ms) const {
+	double period = period_ms();
+	if (period <= 0.0) return ms;
+	double next = last_swap_ms + period;
+	if (next <= ms) {
+		next += std::ceil((ms - next) / period) * period;
+		if (next <= ms) next += period;
+	}
+	return next;
+}
+
+FramePacer::FramePacer(double target_hz, double spin_ms_) : period_ms(1000.0 / target_hz), spin_ms(spin_ms_) {
+}
+
+double FramePacer::now_ms() {
+	#if defined(_WIN32) || defined(__APPLE__)
+	return std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now().time_since_epoch()).count();
+	#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec * 1e-6;
+	#endif
+}
+
+//sleep until 'ms' on FramePacer::now_ms()'s clock (or, usually, somewhat after):
+static void sleep_until_ms(double ms) {
+	#if defined(_WIN32) || defined(__APPLE__)
+	double remaining_ms = ms - FramePacer::now_ms();
+	if (remaining_ms > 0.0) std::this_thread::sleep_for(std::chrono::duration< double, std::milli >(remaining_ms));
+	#else
+	//an absolute deadline, so a signal (EINTR) just means sleeping again:
+	timespec until;
+	until.tv_sec = time_t(ms / 1000.0);
+	until.tv_nsec = std::min(999999999L, std::max(0L, long((ms - until.tv_sec * 1000.0) * 1e6)));
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR) { }
+	#endif
+}
+
+void FramePacer::wait() {
+	double now = now_ms();
+	if (frames == 0) {
+		next_ms = now;
+	} else {
+		next_ms += period_ms;
+		if (now > next_ms + period_ms) {
+			//more than a frame behind: start the schedule again from here rather than rushing to catch up
+			late += 1;
+			next_ms = now;
+		}
+	}
+
+	//sleep most of the way, then spin the rest:
+	if (now < next_ms - spin_ms) {
+		double wake_ms = next_ms - spin_ms;
+		sleep_until_ms(wake_ms);
+		now = now_ms();
+		max_oversleep_ms = std::max(max_oversleep_ms, now - wake_ms);
+	}
+	double spin_start_ms = now;
+	while (now < next_ms) {
+		now = now_ms();
+	}
+	spin_total_ms += now - spin_start_ms;
+
+	if (frames > 0) {
+		double interval = now - last_start_ms;
+		double jitter = std::abs(interval - period_ms);
+		jitter_bins[uint32_t(std::min< double >(JitterBins - 1, jitter / JitterBinMs))] += 1;
+		intervals += 1;
+		interval_total_ms += interval;
+		interval_squares += jitter * jitter;
+		max_jitter_ms = std::max(max_jitter_ms, jitter);
+	}
+	last_start_ms = now;
+	frames += 1;
+}
+
+double FramePacer::jitter_percentile(float p) const {
+	if (intervals == 0) return 0.0;
+	uint64_t want = std::max< uint64_t >(1, uint64_t(p * intervals + 0.5));
+	uint64_t seen = 0;
+	for (uint32_t b = 0; b < JitterBins; ++b) {
+		seen += jitter_bins[b];
+		if (seen >= want) return (b + 1 == JitterBins ? max_jitter_ms : std::min(max_jitter_ms, (b + 1) * JitterBinMs));
+	}
+	return max_jitter_ms;
+}
+
+void FramePacer::print(std::ostream &out, char const *name) const {
+	std::ios::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+	out << std::fixed << std::setprecision(3);
+	out << name << ": " << frames << " frames, target " << period_ms << "ms (" << 1000.0 / period_ms << " Hz); "
+	    << "interval mean " << (intervals ? interval_total_ms / intervals : 0.0) << "ms, rms error "
+	    << (intervals ? std::sqrt(interval_squares / intervals) : 0.0) << "ms." << std::endl;
+	out << "  jitter p50 " << jitter_percentile(0.50f) << "ms, p95 " << jitter_percentile(0.95f) << "ms, p99 "
+	    << jitter_percentile(0.99f) << "ms, max " << max_jitter_ms << "ms; " << late << " late frames; sleep overshoot up to "
+	    << max_oversleep_ms << "ms; spinning " << (frames ? spin_total_ms / frames : 0.0) << "ms/frame (window " << spin_ms << "ms)." << std::endl;
+	out.precision(precision);
+	out.flags(flags);
+}
@@ -0,0 +1,87 @@
+#pragma once
+/*
+ * Pacing helps the frame loop decide when to do its work.
+ *
+ * VsyncPredictor watches when SDL_GL_SwapWindow returns (under vsync, just
+ * after each vblank), estimates the refresh period from the median of recent
+ * intervals, and predicts upcoming vblanks. './main --late-latch' uses it to
+ * sleep until just before the next one, so input is read as late as possible.
+ *
+ * FramePacer holds the frame loop to a target rate when there is no vsync to
+ * do it. It keeps an absolute schedule on the monotonic clock, and it sleeps
+ * (clock_nanosleep on CLOCK_MONOTONIC where that exists) until shortly before
+ * each frame is due, then spins the last stretch, because a sleep can
+ * overshoot by more than the jitter we want. It also records how far each
+ * frame's start strays from the target period, and print() reports that.
+ * It needs no window, so 'tennis_sim --pace' can test it headless.
+ *
+ * Example:
+ *   VsyncPredictor vsync;
+ *   //...after each swap:
+ *   vsync.swapped(now_ms);
+ *   //...at the top of the next frame:
+ *   if (vsync.ready()) wake_at = vsync.next_vsync_ms(now_ms) - budget_ms;
+ *
+ *   FramePacer pacer(60.0);
+ *   while (running) {
+ *     pacer.wait(); //returns when the next frame is due
+ *     //...frame work...
+ *   }
+ *   pacer.print(std::cout);
+ */
+
+#include <cstdint>
+#include <iosfwd>
+
+struct VsyncPredictor {
+	//call with the time (in ms, any origin) each swap returns:
+	void swapped(double ms);
+
+	//true once enough swaps have been seen to predict from:
+	bool ready() const { return interval_count >= 4; }
+	//estimated refresh period (median of recent swap intervals):
+	double period_ms() const;
+	//the first predicted vblank after 'ms':
+	double next_vsync_ms(double ms) const;
+
+	uint64_t swaps = 0;
+	uint64_t missed = 0; //vblanks passed without a swap (intervals of more than 1.5 periods)
+
+	static const uint32_t History = 16;
+	double intervals[History];
+	uint32_t interval_count = 0;
+	uint32_t next_interval = 0;
+	double last_swap_ms = 0.0;
+};
+
+struct FramePacer {
+	FramePacer(double target_hz, double spin_ms = 1.0);
+
+	//block until the next frame is due (call once per frame, before its work):
+	void wait();
+	//the pacer's clock (CLOCK_MONOTONIC where available), in ms:
+	static double now_ms();
+	//frame count, period mean and deviation, jitter percentiles, late frames, and sleep overshoot:
+	void print(std::ostream &out, char const *name = "Frame pacing") const;
+
+	double period_ms;
+	double spin_ms; //how long before each deadline sleeping stops and spinning starts
+
+	uint64_t frames = 0;
+	uint64_t late = 0; //frames started more than a period behind schedule (the schedule restarts from them)
+	double next_ms = 0.0; //when the next frame is due
+
+	//jitter: how far each interval between frame starts is from period_ms:
+	static const uint32_t JitterBins = 1000; //10us each, so up to 10ms; larger errors go in the last bin
+	static constexpr double JitterBinMs = 0.01;
+	uint32_t jitter_bins[JitterBins] = { };
+	uint64_t intervals = 0;
+	double interval_total_ms = 0.0;
+	double interval_squares = 0.0; //(sum of squared differences from period_ms)
+	double max_jitter_ms = 0.0;
+	double last_start_ms = 0.0;
+	double max_oversleep_ms = 0.0; //latest a sleep has woken past its target
+	double spin_total_ms = 0.0;
+	//smallest jitter with at least fraction 'p' of intervals at or below it:
+	double jitter_percentile(float p) const;
+};
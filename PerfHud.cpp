@@ -0,0 +1,134 @@
+#include "PerfHud.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+const uint32_t PerfHud::History;
+const uint32_t PerfHud::MaxRectangles;
+
+void PerfHud::add(Graph graph, float ms) {
+	history[graph][next[graph]] = std::max(ms, 0.0f);
+	next[graph] = (next[graph] + 1) % History;
+}
+
+void PerfHud::set_counts(DrawCounters const &after, DrawCounters const &before) {
+	frame_counts.draw_calls = after.draw_calls - before.draw_calls;
+	frame_counts.rectangles = after.rectangles - before.rectangles;
+	frame_counts.vertices = after.vertices - before.vertices;
+	frame_counts.bytes_uploaded = after.bytes_uploaded - before.bytes_uploaded;
+}
+
+//add 'value' (shown with 'decimals' digits after a point, so value 123 with 1 decimal reads "12.3")
+// as seven-segment digits 'unit' per cell unit, lower left at 'at'; returns the x just past it:
+static float add_number(Draw &draw, glm::vec2 at, float unit, uint64_t value, uint32_t decimals, glm::u8vec4 const &color) {
+	//segments as {min, max} in a [0,4]x[0,7] cell (as main.cpp's score digits):
+	static glm::vec2 const segments[7][2] = {
+		{glm::vec2(1.0f, 6.0f), glm::vec2(3.0f, 7.0f)},
+		{glm::vec2(0.0f, 4.0f), glm::vec2(1.0f, 6.0f)},
+		{glm::vec2(3.0f, 4.0f), glm::vec2(4.0f, 6.0f)},
+		{glm::vec2(1.0f, 3.0f), glm::vec2(3.0f, 4.0f)},
+		{glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 3.0f)},
+		{glm::vec2(3.0f, 1.0f), glm::vec2(4.0f, 3.0f)},
+		{glm::vec2(1.0f, 0.0f), glm::vec2(3.0f, 1.0f)},
+	};
+	static uint8_t const lit[10] = { 0x77, 0x24, 0x5d, 0x6d, 0x2e, 0x6b, 0x7b, 0x25, 0x7f, 0x6f };
+
+	//digits, least significant first (at least one before the point):
+	uint8_t digits[24];
+	uint32_t count = 0;
+	do {
+		digits[count++] = uint8_t(value % 10);
+		value /= 10;
+	} while (value != 0 || count <= decimals);
+
+	for (uint32_t i = count; i > 0; --i) {
+		uint8_t d = digits[i - 1];
+		for (uint32_t s = 0; s < 7; ++s) {
+			if (lit[d] & (1 << s)) draw.add_rectangle(at + unit * segments[s][0], at + unit * segments[s][1], color);
+		}
+		at.x += 5.0f * unit;
+		if (i - 1 == decimals && decimals != 0) {
+			draw.add_rectangle(at, at + glm::vec2(unit), color);
+			at.x += 2.0f * unit;
+		}
+	}
+	return at.x;
+}
+
+void PerfHud::build(Draw &draw) const {
+	glm::u8vec4 const graph_colors[GraphCount] = {
+		glm::u8vec4(0x40, 0xd0, 0x40, 0xff), //update: green
+		glm::u8vec4(0xe0, 0xe0, 0x40, 0xff), //geometry: yellow
+		glm::u8vec4(0xff, 0x90, 0x20, 0xff), //submit: orange
+		glm::u8vec4(0xb0, 0x60, 0xff, 0xff), //GPU: purple
+		glm::u8vec4(0x40, 0x90, 0xff, 0xff), //swap wait: blue
+	};
+	glm::u8vec4 const panel = glm::u8vec4(0x18, 0x18, 0x18, 0xff);
+	glm::u8vec4 const graph_background = glm::u8vec4(0x30, 0x30, 0x30, 0xff);
+	glm::u8vec4 const white = glm::u8vec4(0xff, 0xff, 0xff, 0xff);
+	glm::u8vec4 const grey = glm::u8vec4(0x90, 0x90, 0x90, 0xff);
+
+	float const pad = 0.01f;
+	float const row_height = 0.08f, graph_height = 0.064f;
+	float const bar_width = 0.005f;
+	float const counts_height = 0.06f;
+	float const width = 1.14f;
+
+	draw.add_rectangle(origin, origin + glm::vec2(width, 2.0f * counts_height + GraphCount * row_height + 2.0f * pad), panel);
+
+	//a row per timing, update at the top:
+	for (uint32_t g = 0; g < GraphCount; ++g) {
+		glm::vec2 at = origin + glm::vec2(pad, pad + 2.0f * counts_height + (GraphCount - 1 - g) * row_height);
+		float const *samples = history[g];
+		glm::u8vec4 color = graph_colors[g];
+
+		draw.add_rectangle(at, at + glm::vec2(0.03f, graph_height), color);
+
+		glm::vec2 graph = at + glm::vec2(0.04f, 0.0f);
+		draw.add_rectangle(graph, graph + glm::vec2(History * bar_width, graph_height), graph_background);
+		float worst = 0.0f;
+		for (uint32_t i = 0; i < History; ++i) {
+			float ms = samples[(next[g] + i) % History]; //oldest first
+			worst = std::max(worst, ms);
+			float height = std::min(std::ceil(ms / scale_ms * graph_height / pixel) * pixel, graph_height);
+			if (height <= 0.0f) continue;
+			glm::vec2 bar = graph + glm::vec2(i * bar_width, 0.0f);
+			draw.add_rectangle(bar, bar + glm::vec2(bar_width, height), (ms > scale_ms ? white : color));
+		}
+		//one 60 Hz frame:
+		float frame_y = graph.y + (1000.0f / 60.0f) / scale_ms * graph_height;
+		draw.add_rectangle(glm::vec2(graph.x, frame_y), glm::vec2(graph.x + History * bar_width, frame_y + 0.003f), grey);
+
+		//latest and worst, to a tenth of a millisecond:
+		float latest = samples[(next[g] + History - 1) % History];
+		glm::vec2 numbers = graph + glm::vec2(History * bar_width + 0.02f, 0.004f);
+		add_number(draw, numbers, 0.008f, uint64_t(std::min(latest, 99999.0f) * 10.0f + 0.5f), 1, color);
+		add_number(draw, numbers + glm::vec2(0.22f, 0.0f), 0.008f, uint64_t(std::min(worst, 99999.0f) * 10.0f + 0.5f), 1, white);
+	}
+
+	//counts for the last frame along the bottom:
+	uint64_t const counts[4] = { frame_counts.rectangles, frame_counts.vertices, frame_counts.bytes_uploaded, frame_counts.draw_calls };
+	glm::u8vec4 const count_colors[4] = {
+		white,
+		grey,
+		glm::u8vec4(0x40, 0xe0, 0xe0, 0xff),
+		glm::u8vec4(0xff, 0x80, 0xc0, 0xff),
+	};
+	for (uint32_t c = 0; c < 4; ++c) {
+		glm::vec2 at = origin + glm::vec2(pad + c * 0.28f, pad + 0.008f);
+		draw.add_rectangle(at, at + glm::vec2(0.02f, 0.042f), count_colors[c]);
+		add_number(draw, at + glm::vec2(0.03f, 0.0f), 0.006f, counts[c], 0, count_colors[c]);
+	}
+
+	//and above them, the overlay's own rectangles before and after optimization:
+	uint64_t const optimized[2] = { optimize_stats.rects_in, optimize_stats.rects_out };
+	glm::u8vec4 const optimized_colors[2] = {
+		glm::u8vec4(0xd0, 0xb0, 0x80, 0xff),
+		glm::u8vec4(0xa0, 0xff, 0xa0, 0xff),
+	};
+	for (uint32_t c = 0; c < 2; ++c) {
+		glm::vec2 at = origin + glm::vec2(pad + c * 0.28f, pad + counts_height + 0.008f);
+		draw.add_rectangle(at, at + glm::vec2(0.02f, 0.042f), optimized_colors[c]);
+		add_number(draw, at + glm::vec2(0.03f, 0.0f), 0.006f, optimized[c], 0, optimized_colors[c]);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+/*
+ * PerfHud is an on-screen overlay of recent frame timings and draw counts, for
+ * finding hitches without attaching a profiler.
+ *
+ * Each frame, main records how long it spent in the simulation update,
+ * building geometry, submitting draws (Draw::draw and batch draws), and
+ * waiting in SDL_GL_SwapWindow. A GL timer query supplies the GPU time a few
+ * frames later. main also records the frame's change in 'draw_counters'.
+ *
+ * build() adds the overlay to a Draw as plain rectangles. Each timing gets a
+ * row: a color swatch, a bar graph of the last History frames (the line marks
+ * one 60 Hz frame, and bars past the top of the scale are drawn white), then
+ * its latest and worst values in ms as seven-segment digits. The rows, top to
+ * bottom, are:
+ *   update (green), geometry (yellow), submit (orange), GPU (purple), swap wait (blue)
+ * The bottom row has the last frame's rectangles (white), vertices (grey),
+ * bytes uploaded (cyan) and draw calls (pink). Above it are the overlay's own
+ * rectangles before (tan) and after (light green) Draw's merge/cull pass, as
+ * reported by set_optimize_stats().
+ *
+ * Bar heights are snapped to whole pixels ('pixel'), since finer differences
+ * can't be seen; runs of equal bars then merge into one rectangle when the
+ * overlay is drawn with 'optimize' set.
+ *
+ * History is kept in fixed arrays and build() only adds rectangles, so it
+ * doesn't allocate when the Draw has room for MaxRectangles more.
+ *
+ * Example:
+ *   PerfHud hud;
+ *   //...each frame:
+ *   hud.add(PerfHud::Update, update_ms);
+ *   hud.set_counts(draw_counters, counters_at_frame_start);
+ *   hud.build(hud_draw); //(hud_draw.optimize = true)
+ *   hud_draw.draw();
+ *   hud.set_optimize_stats(hud_draw.optimize_stats);
+ */
+
+#include "Draw.hpp"
+
+struct PerfHud {
+	enum Graph {
+		Update, //simulation steps
+		Geometry, //adding rectangles on the CPU
+		Submit, //Draw::draw() and batch draws
+		GPU, //timer query around the frame's GL commands
+		SwapWait, //inside SDL_GL_SwapWindow
+		GraphCount
+	};
+	static const uint32_t History = 128; //frames shown in each graph
+	static const uint32_t MaxRectangles = 2048; //most rectangles build() adds
+
+	//record a time for the newest frame (each graph advances on its own, since GPU times arrive late):
+	void add(Graph graph, float ms);
+	//the last frame's draw counts, as the difference between two readings of draw_counters:
+	void set_counts(DrawCounters const &after, DrawCounters const &before);
+	//rectangles in and out of the merge/cull pass when the overlay was last drawn:
+	void set_optimize_stats(Draw::OptimizeStats const &stats) { optimize_stats = stats; }
+	//add the overlay's rectangles to 'draw' (the caller draws them):
+	void build(Draw &draw) const;
+
+	float scale_ms = 100.0f / 3.0f; //time at the top of each graph (two 60 Hz frames)
+	glm::vec2 origin = glm::vec2(-0.98f, -0.98f); //lower left corner of the overlay
+	float pixel = 2.0f / 640.0f; //height of a pixel in overlay units
+
+	float history[GraphCount][History] = { };
+	uint32_t next[GraphCount] = { };
+	DrawCounters frame_counts;
+	Draw::OptimizeStats optimize_stats;
+};
@@ -0,0 +1,77 @@
+#include "Predict.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PREDICT_SSE2
+#endif
+
+Crossing predict_crossing(glm::vec2 const &ball, glm::vec2 const &velocity, float plane_x) {
+	Crossing crossing;
+	float t = (plane_x - ball.x) / velocity.x;
+	if (!(t >= 0.0f) || velocity.x == 0.0f) {
+		crossing.time = std::numeric_limits< float >::infinity();
+		crossing.y = ball.y;
+		crossing.velocity_y = velocity.y;
+		return crossing;
+	}
+	//unfolded height above the bottom wall, folded into one period of up-and-back:
+	float u = ball.y + 1.0f + velocity.y * t;
+	float m = u - 4.0f * std::floor(u * 0.25f);
+	bool mirrored = (m > 2.0f);
+	crossing.time = t;
+	crossing.y = (mirrored ? 4.0f - m : m) - 1.0f;
+	crossing.velocity_y = (mirrored ? -velocity.y : velocity.y);
+	return crossing;
+}
+
+void predict_crossings(size_t count, float plane_x,
+	float const *x, float const *y, float const *vx, float const *vy,
+	float *time, float *cross_y, float *cross_velocity_y) {
+	size_t i = 0;
+
+	#ifdef PREDICT_SSE2
+	__m128 const plane = _mm_set1_ps(plane_x);
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const one = _mm_set1_ps(1.0f);
+	__m128 const two = _mm_set1_ps(2.0f);
+	__m128 const four = _mm_set1_ps(4.0f);
+	__m128 const quarter = _mm_set1_ps(0.25f);
+	__m128 const sign = _mm_set1_ps(-0.0f);
+	__m128 const never = _mm_set1_ps(std::numeric_limits< float >::infinity());
+	for (; i + 4 <= count; i += 4) {
+		__m128 bx = _mm_loadu_ps(x + i);
+		__m128 by = _mm_loadu_ps(y + i);
+		__m128 bvx = _mm_loadu_ps(vx + i);
+		__m128 bvy = _mm_loadu_ps(vy + i);
+
+		__m128 t = _mm_div_ps(_mm_sub_ps(plane, bx), bvx);
+		__m128 ahead = _mm_andnot_ps(_mm_cmpeq_ps(bvx, zero), _mm_cmpge_ps(t, zero));
+		t = _mm_and_ps(ahead, t); //(keeps u finite in lanes that won't cross)
+
+		__m128 u = _mm_add_ps(_mm_add_ps(by, one), _mm_mul_ps(bvy, t));
+		//floor(u / 4), by truncating and stepping down for negative non-integers:
+		__m128 q = _mm_mul_ps(u, quarter);
+		__m128 f = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+		f = _mm_sub_ps(f, _mm_and_ps(_mm_cmpgt_ps(f, q), one));
+		__m128 m = _mm_sub_ps(u, _mm_mul_ps(four, f));
+		__m128 mirrored = _mm_cmpgt_ps(m, two);
+		__m128 folded = _mm_or_ps(_mm_and_ps(mirrored, _mm_sub_ps(four, m)), _mm_andnot_ps(mirrored, m));
+
+		__m128 out_y = _mm_sub_ps(folded, one);
+		__m128 out_vy = _mm_xor_ps(bvy, _mm_and_ps(mirrored, sign));
+		_mm_storeu_ps(time + i, _mm_or_ps(_mm_and_ps(ahead, t), _mm_andnot_ps(ahead, never)));
+		_mm_storeu_ps(cross_y + i, _mm_or_ps(_mm_and_ps(ahead, out_y), _mm_andnot_ps(ahead, by)));
+		_mm_storeu_ps(cross_velocity_y + i, _mm_or_ps(_mm_and_ps(ahead, out_vy), _mm_andnot_ps(ahead, bvy)));
+	}
+	#endif
+
+	for (; i < count; ++i) {
+		Crossing c = predict_crossing(glm::vec2(x[i], y[i]), glm::vec2(vx[i], vy[i]), plane_x);
+		time[i] = c.time;
+		cross_y[i] = c.y;
+		cross_velocity_y[i] = c.velocity_y;
+	}
+}
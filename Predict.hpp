@@ -0,0 +1,38 @@
+#pragma once
+/*
+ * Predict answers "where will the ball cross the line x = plane_x?" in
+ * constant time, however many times it bounces off the top and bottom walls
+ * (y = -1 and y = 1) on the way.
+ *
+ * Reflections are unfolded: in a world where the walls are mirrors, the ball
+ * flies straight, and its real y is that straight-line y folded back into
+ * [-1,1] with period 4 (up through one court, back down through the mirror
+ * image). Only the walls are considered -- not the target, paddle, or left
+ * wall -- so ask for the plane the ball is heading toward (e.g. the paddle
+ * face, x = 0.94, for a ball moving right).
+ *
+ * Example:
+ *   Crossing c = predict_crossing(state.ball, state.ball_velocity, 0.94f);
+ *   if (std::isfinite(c.time)) paddle_goal = c.y;
+ *   //...or, for many balls stored as arrays:
+ *   predict_crossings(count, plane_x, x, y, vx, vy, times, ys, vys);
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+struct Crossing {
+	float time; //seconds until the crossing (infinity if the ball is not heading toward the plane)
+	float y; //where it crosses
+	float velocity_y; //vertical velocity as it crosses (the sign flips with each wall bounce)
+};
+
+Crossing predict_crossing(glm::vec2 const &ball, glm::vec2 const &velocity, float plane_x);
+
+//predict_crossing() for 'count' balls stored as arrays (SSE2 when available;
+// results match the single version to within rounding):
+void predict_crossings(size_t count, float plane_x,
+	float const *x, float const *y, float const *vx, float const *vy,
+	float *time, float *cross_y, float *cross_velocity_y);
@@ -0,0 +1,81 @@
+#include "Random.hpp"
+
+void philox4x32(uint32_t const counter[4], uint32_t const key_[2], uint32_t out[4]) {
+	uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+	uint32_t key[2] = { key_[0], key_[1] };
+	for (uint32_t round = 0; round < 10; ++round) {
+		if (round > 0) {
+			key[0] += 0x9E3779B9;
+			key[1] += 0xBB67AE85;
+		}
+		uint64_t p0 = uint64_t(0xD2511F53) * c[0];
+		uint64_t p1 = uint64_t(0xCD9E8D57) * c[2];
+		uint32_t next[4] = {
+			uint32_t(p1 >> 32) ^ c[1] ^ key[0],
+			uint32_t(p1),
+			uint32_t(p0 >> 32) ^ c[3] ^ key[1],
+			uint32_t(p0),
+		};
+		c[0] = next[0]; c[1] = next[1]; c[2] = next[2]; c[3] = next[3];
+	}
+	out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = c[3];
+}
+
+uint32_t RandomStream::next() {
+	if ((position >> 2) != block_counter || seed != block_key[0] || stream != block_key[1]) {
+		uint32_t counter[4] = { uint32_t(position >> 2), uint32_t(position >> 34), 0, 0 };
+		block_key[0] = seed;
+		block_key[1] = stream;
+		block_counter = position >> 2;
+		philox4x32(counter, block_key, block);
+	}
+	uint32_t word = block[position & 3];
+	++position;
+	return word;
+}
+
+void random_fill(uint32_t seed, uint32_t stream, uint64_t position, uint32_t *out, size_t count) {
+	uint32_t key[2] = { seed, stream };
+	size_t i = 0;
+
+	//scalar up to the next block boundary:
+	RandomStream head(seed, stream, position);
+	for (; i < count && (position & 3); ++i) {
+		out[i] = head.next();
+		++position;
+	}
+
+	#ifdef RANDOM_SSE2
+	//four blocks (sixteen draws) at a time, computed side by side and then transposed into order:
+	__m128i const keys[2] = { _mm_set1_epi32(int32_t(key[0])), _mm_set1_epi32(int32_t(key[1])) };
+	for (; i + 16 <= count; i += 16, position += 16) {
+		uint64_t block = position >> 2;
+		__m128i c[4] = {
+			_mm_setr_epi32(int32_t(block), int32_t(block + 1), int32_t(block + 2), int32_t(block + 3)),
+			_mm_setr_epi32(int32_t(block >> 32), int32_t((block + 1) >> 32), int32_t((block + 2) >> 32), int32_t((block + 3) >> 32)),
+			_mm_setzero_si128(),
+			_mm_setzero_si128(),
+		};
+		philox4x32_sse2(c, keys);
+		//c[w] holds word w of blocks 0-3; transpose so each register holds one block:
+		__m128i t0 = _mm_unpacklo_epi32(c[0], c[1]);
+		__m128i t1 = _mm_unpacklo_epi32(c[2], c[3]);
+		__m128i t2 = _mm_unpackhi_epi32(c[0], c[1]);
+		__m128i t3 = _mm_unpackhi_epi32(c[2], c[3]);
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(out + i + 0), _mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(out + i + 4), _mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(out + i + 8), _mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(out + i + 12), _mm_unpackhi_epi64(t2, t3));
+	}
+	#endif
+
+	//whole blocks, then whatever is left:
+	for (; i + 4 <= count; i += 4, position += 4) {
+		uint32_t counter[4] = { uint32_t(position >> 2), uint32_t(position >> 34), 0, 0 };
+		philox4x32(counter, key, out + i);
+	}
+	RandomStream tail(seed, stream, position);
+	for (; i < count; ++i) {
+		out[i] = tail.next();
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+/*
+ * Random numbers from Philox4x32-10, a counter-based generator (Salmon et
+ * al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11): each 128-bit
+ * counter and 64-bit key map to four random 32-bit words, with no hidden
+ * state. So any game (or thread, or SIMD lane) can have its own stream just
+ * by using its own key, and any point in a stream can be computed directly.
+ *
+ * RandomStream is the usual way to draw numbers: stream 'stream' of seed
+ * 'seed' is the key (seed, stream), and draw i is word i % 4 of the block at
+ * counter i / 4. It keeps the last block it computed, so only every fourth
+ * draw runs Philox.
+ *
+ * Example:
+ *   RandomStream random(seed, game_index);
+ *   float x = random.next_float(); //in [0,1]
+ *   //...or, many at once:
+ *   random_fill(seed, game_index, 0, words.data(), words.size());
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RANDOM_SSE2
+#endif
+
+//one Philox4x32-10 block:
+void philox4x32(uint32_t const counter[4], uint32_t const key[2], uint32_t out[4]);
+
+struct RandomStream {
+	RandomStream(uint32_t seed_ = 0, uint32_t stream_ = 0, uint64_t position_ = 0)
+		: seed(seed_), stream(stream_), position(position_) {
+	}
+	//next 32 random bits:
+	uint32_t next();
+	//next number in [0,1] (24 bits of precision):
+	float next_float() { return to_float(next()); }
+
+	static float to_float(uint32_t bits) { return (bits >> 8) / float(0xffffff); }
+
+	uint32_t seed;
+	uint32_t stream;
+	uint64_t position; //draws so far
+
+	//the last block computed, and the key and counter it was computed for (so a stream moved
+	// by changing seed, stream or position never reads a stale block):
+	uint32_t block[4] = { };
+	uint32_t block_key[2] = { };
+	uint64_t block_counter = ~uint64_t(0);
+};
+
+//fill 'out' with 'count' draws of stream (seed, stream), starting at draw 'position'
+// (the same numbers RandomStream would give; uses SSE2 when available):
+void random_fill(uint32_t seed, uint32_t stream, uint64_t position, uint32_t *out, size_t count);
+
+#ifdef RANDOM_SSE2
+//Philox4x32-10 for four independent blocks at once, stored by word: counter[w]
+// holds word w of each of the four counters (likewise key and the result):
+inline void philox4x32_sse2(__m128i counter[4], __m128i const key_[2]) {
+	//(_mm_mul_epu32 multiplies lanes 0 and 2; lanes 1 and 3 are shifted down to do the rest)
+	auto mulhilo = [](__m128i a, __m128i m, __m128i &hi, __m128i &lo) {
+		__m128i even = _mm_mul_epu32(a, m);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+		lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+		hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,3,1)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,3,1)));
+	};
+	__m128i const M0 = _mm_set1_epi32(int32_t(0xD2511F53));
+	__m128i const M1 = _mm_set1_epi32(int32_t(0xCD9E8D57));
+	__m128i key[2] = { key_[0], key_[1] };
+	for (uint32_t round = 0; round < 10; ++round) {
+		if (round > 0) {
+			key[0] = _mm_add_epi32(key[0], _mm_set1_epi32(int32_t(0x9E3779B9)));
+			key[1] = _mm_add_epi32(key[1], _mm_set1_epi32(int32_t(0xBB67AE85)));
+		}
+		__m128i hi0, lo0, hi1, lo1;
+		mulhilo(counter[0], M0, hi0, lo0);
+		mulhilo(counter[2], M1, hi1, lo1);
+		counter[0] = _mm_xor_si128(_mm_xor_si128(hi1, counter[1]), key[0]);
+		counter[1] = lo1;
+		counter[2] = _mm_xor_si128(_mm_xor_si128(hi0, counter[3]), key[1]);
+		counter[3] = lo0;
+	}
+}
+#endif
@@ -0,0 +1,58 @@
+#include "SimThread.hpp"
+
+SimThread::SimThread(uint32_t seed, float rate_hz, bool fixed_point_, float spin_ms)
+	: dt(1.0f / rate_hz), fixed_point(fixed_point_), pacer(rate_hz, spin_ms) {
+	state = new_game(seed);
+	fixed_state = new_fixed_game(seed);
+	if (fixed_point) state = to_game_state(fixed_state);
+	input.paddle_y = state.paddle.y;
+
+	//the render thread can draw the starting state before the first step:
+	latest.state = state;
+	snapshots.write_buffer() = latest;
+	snapshots.publish();
+
+	thread = std::thread(&SimThread::run, this);
+}
+
+SimThread::~SimThread() {
+	stop();
+}
+
+void SimThread::stop() {
+	quit.store(true, std::memory_order_release);
+	if (thread.joinable()) thread.join();
+}
+
+void SimThread::run() {
+	while (!quit.load(std::memory_order_acquire)) {
+		pacer.wait();
+
+		//everything sent since the last step (the newest paddle position wins; any serve counts):
+		SimInput in;
+		while (inputs.pop(&in)) {
+			input.paddle_y = in.paddle_y;
+			input.serve = input.serve || in.serve;
+			if (in.motion_ms != 0.0 && in.motion_ms != latest.motion_ms) {
+				latest.motion_ms = in.motion_ms;
+				latest.motion_used_ms = FramePacer::now_ms();
+			}
+		}
+
+		if (fixed_point) {
+			FixedGameInput fixed_input;
+			fixed_input.paddle_y = to_fixed(input.paddle_y);
+			fixed_input.serve = input.serve;
+			step(fixed_state, fixed_input, to_fixed(dt));
+			state = to_game_state(fixed_state);
+		} else {
+			step(state, input, dt);
+		}
+		input.serve = false;
+
+		latest.state = state;
+		latest.steps += 1;
+		snapshots.write_buffer() = latest;
+		snapshots.publish();
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+/*
+ * SimThread runs the game rules on their own thread at a fixed rate (1 kHz by
+ * default, paced by a FramePacer), so a slow swap or driver stall on the
+ * render thread doesn't delay physics.
+ *
+ * The two threads share no locks:
+ *  - input goes to the sim thread through 'inputs', a wait-free
+ *    single-producer/single-consumer ring (SpscQueue). The render thread
+ *    pushes, and the sim thread drains it before every step;
+ *  - after every step the sim thread publishes a SimSnapshot through
+ *    'snapshots', a lock-free TripleBuffer. The render thread takes the
+ *    newest one when it draws. Snapshots it never saw are simply skipped.
+ * Sim rate and render rate are therefore independent. The sim thread's
+ * FramePacer ('pacer') measures the sim rate; the render thread measures
+ * its own.
+ *
+ * Example:
+ *   SimThread sim(seed, 1000.0f); //starts stepping a new game
+ *   //...render thread, each frame:
+ *   SimInput in;
+ *   in.paddle_y = mouse_y;
+ *   sim.inputs.push(in);
+ *   sim.snapshots.update();
+ *   GameState const &state = sim.snapshots.read().state;
+ *   //...at exit:
+ *   sim.stop();
+ *   sim.pacer.print(std::cout, "Sim thread");
+ */
+
+#include "FixedGame.hpp"
+#include "Game.hpp"
+#include "Pacing.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+//TripleBuffer hands the newest value from one writer thread to one reader
+// thread without either waiting. Of the three slots, the writer owns one, the
+// reader owns one, and the third ('present') holds the newest published value.
+// Publishing and reading each swap their own slot with 'present':
+template< typename T >
+struct TripleBuffer {
+	//writer: fill write_buffer(), then publish() it:
+	T &write_buffer() { return slots[back]; }
+	void publish() {
+		back = present.exchange(uint8_t(back | Fresh), std::memory_order_acq_rel) & Index;
+	}
+
+	//reader: take the newest published value, if there is one since the last call (returns true if so):
+	bool update() {
+		if (!(present.load(std::memory_order_relaxed) & Fresh)) return false;
+		front = present.exchange(front, std::memory_order_acq_rel) & Index;
+		return true;
+	}
+	//the value taken by the last update():
+	T const &read() const { return slots[front]; }
+
+	static const uint8_t Index = 0x3;
+	static const uint8_t Fresh = 0x4; //set in 'present' when it holds a value the reader hasn't taken
+	T slots[3];
+	std::atomic< uint8_t > present{ uint8_t(1) };
+	uint8_t back = 0; //(only touched by the writer)
+	uint8_t front = 2; //(only touched by the reader)
+};
+
+//SpscQueue is a fixed-size ring for one producer thread and one consumer
+// thread. push() and pop() each finish in a bounded number of steps, and
+// push() fails rather than waits when the ring is full:
+template< typename T, uint32_t Size >
+struct SpscQueue {
+	static_assert((Size & (Size - 1)) == 0, "SpscQueue size is a power of two.");
+
+	//producer:
+	bool push(T const &value) {
+		uint32_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == Size) return false;
+		items[t & (Size - 1)] = value;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+	//consumer:
+	bool pop(T *value) {
+		uint32_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) return false;
+		*value = items[h & (Size - 1)];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	//(head and tail are padded a cache line apart, so the two threads don't share one; padding
+	// rather than alignas keeps SpscQueue allocatable with plain new before C++17)
+	std::atomic< uint32_t > head{ 0u }; //next to pop
+	char head_pad[64 - sizeof(std::atomic< uint32_t >)];
+	std::atomic< uint32_t > tail{ 0u }; //next to push
+	char tail_pad[64 - sizeof(std::atomic< uint32_t >)];
+	T items[Size];
+};
+
+//what the render thread sends the sim thread:
+struct SimInput {
+	float paddle_y = 0.0f;
+	bool serve = false;
+	double motion_ms = 0.0; //if nonzero, when the mouse motion behind 'paddle_y' happened (caller's clock)
+};
+
+//what the sim thread publishes after each step:
+struct SimSnapshot {
+	GameState state;
+	uint64_t steps = 0; //steps taken so far
+	//the newest input with a motion time that a step has used, and when (FramePacer::now_ms()) it was first used:
+	double motion_ms = 0.0;
+	double motion_used_ms = 0.0;
+};
+
+struct SimThread {
+	//start stepping new_game(seed) (or new_fixed_game(seed) with 'fixed_point') at 'rate_hz' steps per second;
+	// the pacer sleeps until 'spin_ms' before each step, then spins:
+	SimThread(uint32_t seed, float rate_hz, bool fixed_point = false, float spin_ms = 0.2f);
+	~SimThread();
+	SimThread(SimThread const &) = delete;
+	SimThread &operator=(SimThread const &) = delete;
+
+	//stop stepping and wait for the thread to finish (after which 'pacer' may be read):
+	void stop();
+
+	SpscQueue< SimInput, 256 > inputs;
+	TripleBuffer< SimSnapshot > snapshots;
+
+	float dt;
+	bool fixed_point;
+	FramePacer pacer;
+
+	//----- internals (sim thread only) -----
+	void run();
+	GameState state;
+	FixedGameState fixed_state;
+	GameInput input;
+	SimSnapshot latest;
+	std::atomic< bool > quit{ false };
+	std::thread thread;
+};
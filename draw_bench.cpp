@@ -0,0 +1,234 @@
+#include "Draw.hpp"
+#include "GL.hpp"
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//draw_bench compares the Draw (four indexed 12-byte vertices per rectangle),
+// PaletteDraw (four indexed 6-byte vertices) and DrawInstanced (one instance
+// per rectangle) paths by recording and drawing batches of random rectangles
+// into a hidden window. It also times the raw vertex upload for the old
+// six-vertices-per-rectangle layout against the four-vertex layout, to show
+// what the shared quad index buffer saves, and records Draw from several
+// threads at once (through per-thread Recorders) to show how building scales.
+
+struct Rect {
+	glm::vec2 min;
+	glm::vec2 max;
+	glm::u8vec4 color;
+	uint8_t index; //color index for PaletteDraw
+};
+
+static glm::u8vec4 rgba(Rect const &r) { return r.color; }
+static uint8_t palette_index(Rect const &r) { return r.index; }
+
+template< typename D, typename Color >
+static void report(char const *name, std::vector< Rect > const &rects, Color (*color)(Rect const &)) {
+	D draw;
+	uint32_t runs = (rects.size() >= 1000000 ? 3 : 10);
+
+	//warm up (compiles shaders, sizes buffers):
+	for (auto const &r : rects) draw.add_rectangle(r.min, r.max, color(r));
+	draw.draw();
+	glFinish();
+
+	//time recording (add_rectangle calls) and submission (draw() + glFinish()) separately:
+	double build = 0.0;
+	double submit = 0.0;
+	uint64_t streamed_before = draw_stream_stats.bytes_streamed;
+	for (uint32_t run = 0; run < runs; ++run) {
+		auto before = std::chrono::high_resolution_clock::now();
+		for (auto const &r : rects) draw.add_rectangle(r.min, r.max, color(r));
+		auto recorded = std::chrono::high_resolution_clock::now();
+		draw.draw();
+		glFinish();
+		auto after = std::chrono::high_resolution_clock::now();
+		build += std::chrono::duration< double, std::milli >(recorded - before).count() / runs;
+		submit += std::chrono::duration< double, std::milli >(after - recorded).count() / runs;
+	}
+
+	uint64_t bytes = (draw_stream_stats.bytes_streamed - streamed_before) / runs;
+	std::cout << "  " << std::setw(10) << name
+	          << std::setw(14) << bytes
+	          << std::setw(12) << std::fixed << std::setprecision(3) << build
+	          << std::setw(12) << submit
+	          << std::endl;
+}
+
+//like report< Draw >, but with the rectangles split evenly across 'threads' recorders filled in parallel:
+static void report_threaded(char const *name, std::vector< Rect > const &rects, uint32_t threads) {
+	Draw draw;
+	draw.set_recorders(threads);
+	uint32_t runs = (rects.size() >= 1000000 ? 3 : 10);
+
+	auto record = [&]() {
+		std::vector< std::thread > workers;
+		for (uint32_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&draw, &rects, t, threads]() {
+				size_t begin = rects.size() * t / threads;
+				size_t end = rects.size() * (t + 1) / threads;
+				Draw::Recorder &recorder = draw.recorders[t];
+				for (size_t i = begin; i < end; ++i) {
+					recorder.add_rectangle(rects[i].min, rects[i].max, rects[i].color);
+				}
+			});
+		}
+		for (auto &w : workers) w.join();
+	};
+
+	//warm up (sizes recorder and ring buffers):
+	record();
+	draw.draw();
+	glFinish();
+
+	double build = 0.0;
+	double submit = 0.0;
+	uint64_t streamed_before = draw_stream_stats.bytes_streamed;
+	for (uint32_t run = 0; run < runs; ++run) {
+		auto before = std::chrono::high_resolution_clock::now();
+		record();
+		auto recorded = std::chrono::high_resolution_clock::now();
+		draw.draw();
+		glFinish();
+		auto after = std::chrono::high_resolution_clock::now();
+		build += std::chrono::duration< double, std::milli >(recorded - before).count() / runs;
+		submit += std::chrono::duration< double, std::milli >(after - recorded).count() / runs;
+	}
+
+	uint64_t bytes = (draw_stream_stats.bytes_streamed - streamed_before) / runs;
+	std::cout << "  " << std::setw(10) << name
+	          << std::setw(14) << bytes
+	          << std::setw(12) << std::fixed << std::setprecision(3) << build
+	          << std::setw(12) << submit
+	          << std::endl;
+}
+
+//time only building + uploading vertices, with 'corners' (6 or 4) vertices per rectangle:
+static void report_upload(char const *name, std::vector< Rect > const &rects, uint32_t corners) {
+	uint32_t runs = (rects.size() >= 1000000 ? 3 : 10);
+	std::vector< Draw::Vertex > vertices;
+	vertices.reserve(corners * rects.size());
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	double build = 0.0;
+	double submit = 0.0;
+	for (uint32_t run = 0; run < runs; ++run) {
+		vertices.clear();
+		auto before = std::chrono::high_resolution_clock::now();
+		for (auto const &r : rects) {
+			vertices.emplace_back(glm::vec2(r.min.x, r.min.y), r.color);
+			vertices.emplace_back(glm::vec2(r.max.x, r.min.y), r.color);
+			vertices.emplace_back(glm::vec2(r.max.x, r.max.y), r.color);
+			if (corners == 6) {
+				vertices.emplace_back(glm::vec2(r.min.x, r.min.y), r.color);
+				vertices.emplace_back(glm::vec2(r.max.x, r.max.y), r.color);
+			}
+			vertices.emplace_back(glm::vec2(r.min.x, r.max.y), r.color);
+		}
+		auto recorded = std::chrono::high_resolution_clock::now();
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Draw::Vertex) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+		glFinish();
+		auto after = std::chrono::high_resolution_clock::now();
+		build += std::chrono::duration< double, std::milli >(recorded - before).count() / runs;
+		submit += std::chrono::duration< double, std::milli >(after - recorded).count() / runs;
+	}
+
+	glDeleteBuffers(1, &buffer);
+
+	std::cout << "  " << std::setw(10) << name
+	          << std::setw(14) << sizeof(Draw::Vertex) * vertices.size()
+	          << std::setw(12) << std::fixed << std::setprecision(3) << build
+	          << std::setw(12) << submit
+	          << std::endl;
+}
+
+int main(int argc, char **argv) {
+	//create a hidden window with a 3.3 core context, same as main.cpp:
+	SDL_Init(SDL_INIT_VIDEO);
+	SDL_GL_ResetAttributes();
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+	SDL_Window *window = SDL_CreateWindow("draw_bench",
+		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+		256, 256,
+		SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+	);
+	if (!window) {
+		std::cerr << "Error creating SDL window: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context) {
+		SDL_DestroyWindow(window);
+		std::cerr << "Error creating OpenGL context: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+
+	#ifdef _WIN32
+	if (!init_gl_shims()) {
+		std::cerr << "ERROR: failed to initialize shims." << std::endl;
+		return 1;
+	}
+	#endif
+
+	std::unique_ptr< DrawContext > draw_context(new DrawContext());
+	draw_context->warm_up();
+
+	srand(0);
+	auto rnd = [](){ return (rand()/(float)RAND_MAX)*2.0f - 1.0f; };
+
+	std::cout << "  " << std::setw(10) << "path"
+	          << std::setw(14) << "bytes/frame"
+	          << std::setw(12) << "ms build"
+	          << std::setw(12) << "ms submit" << std::endl;
+
+	std::vector< glm::u8vec4 > palette;
+	for (uint32_t i = 0; i < 256; ++i) {
+		palette.emplace_back(rand() & 0xff, rand() & 0xff, rand() & 0xff, 0xff);
+	}
+	set_draw_palette(palette);
+
+	for (uint32_t count : {10000, 100000, 1000000}) {
+		std::vector< Rect > rects;
+		rects.reserve(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			glm::vec2 a(rnd(), rnd());
+			uint8_t index = rand() & 0xff;
+			rects.push_back(Rect{a, a + glm::vec2(0.01f, 0.01f), palette[index], index});
+		}
+
+		std::cout << count << " rectangles:" << std::endl;
+		report< Draw >("Draw", rects, rgba);
+		report< PaletteDraw >("palette", rects, palette_index);
+		report< DrawInstanced >("instanced", rects, rgba);
+		report_threaded("2 threads", rects, 2);
+		report_threaded("4 threads", rects, 4);
+		report_upload("6-vert up", rects, 6);
+		report_upload("4-vert up", rects, 4);
+	}
+
+	std::cout << "stream ring (" << (draw_stream_stats.persistent ? "persistently mapped" : "mapped per upload") << "): " << draw_stream_stats.bytes_streamed << " bytes streamed, "
+	          << draw_stream_stats.wraps << " wraps, "
+	          << draw_stream_stats.fence_waits << " fence waits, "
+	          << draw_stream_stats.grows << " grows" << std::endl;
+
+	draw_context.reset();
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+
+	return 0;
+}
@@ -6,6 +6,7 @@
 	PFNGL ## TYPE ## PROC gl ## NAME = NULL;
 #include "gl_shims.hpp"
 #undef DO
+#undef DO_OPTIONAL
 #undef GL_SHIMS_HPP
 
 bool init_gl_shims() {
@@ -16,6 +17,8 @@ bool init_gl_shims() {
 			std::cerr << "Error binding "  "gl" #NAME << std::endl; \
 			failed = true; \
 		}
+	#define DO_OPTIONAL(TYPE, NAME) \
+		gl ## NAME = (PFNGL ## TYPE ## PROC)SDL_GL_GetProcAddress("gl" #NAME);
 #include "gl_shims.hpp"
 	return !failed;
 }
@@ -72,6 +72,11 @@ GLAPI void APIENTRY glViewport (GLint x, GLint y, GLsizei width, GLsizei height)
 #define DO(TYPE, NAME) 	extern PFNGL ## TYPE ## PROC gl ## NAME;
 #endif
 
+//optional functions are left NULL if the driver doesn't provide them:
+#ifndef DO_OPTIONAL
+#define DO_OPTIONAL(TYPE, NAME) DO(TYPE, NAME)
+#endif
+
 
 
 // GL_VERSION_1_1 extensions:
@@ -134,6 +139,7 @@ DO(ISBUFFER, IsBuffer)
 DO(BUFFERDATA, BufferData)
 DO(BUFFERSUBDATA, BufferSubData)
 DO(GETBUFFERSUBDATA, GetBufferSubData)
+DO(MAPBUFFER, MapBuffer)
 DO(UNMAPBUFFER, UnmapBuffer)
 DO(GETBUFFERPARAMETERIV, GetBufferParameteriv)
 DO(GETBUFFERPOINTERV, GetBufferPointerv)
@@ -299,6 +305,7 @@ DO(CLEARBUFFERIV, ClearBufferiv)
 DO(CLEARBUFFERUIV, ClearBufferuiv)
 DO(CLEARBUFFERFV, ClearBufferfv)
 DO(CLEARBUFFERFI, ClearBufferfi)
+DO(GETSTRINGI, GetStringi)
 DO(ISRENDERBUFFER, IsRenderbuffer)
 DO(BINDRENDERBUFFER, BindRenderbuffer)
 DO(DELETERENDERBUFFERS, DeleteRenderbuffers)
@@ -319,6 +326,7 @@ DO(GENERATEMIPMAP, GenerateMipmap)
 DO(BLITFRAMEBUFFER, BlitFramebuffer)
 DO(RENDERBUFFERSTORAGEMULTISAMPLE, RenderbufferStorageMultisample)
 DO(FRAMEBUFFERTEXTURELAYER, FramebufferTextureLayer)
+DO(MAPBUFFERRANGE, MapBufferRange)
 DO(FLUSHMAPPEDBUFFERRANGE, FlushMappedBufferRange)
 DO(BINDVERTEXARRAY, BindVertexArray)
 DO(DELETEVERTEXARRAYS, DeleteVertexArrays)
@@ -360,4 +368,42 @@ DO(TEXIMAGE3DMULTISAMPLE, TexImage3DMultisample)
 DO(GETMULTISAMPLEFV, GetMultisamplefv)
 DO(SAMPLEMASKI, SampleMaski)
 
+// GL_VERSION_3_3 extensions:
+DO(BINDFRAGDATALOCATIONINDEXED, BindFragDataLocationIndexed)
+DO(GETFRAGDATAINDEX, GetFragDataIndex)
+DO(GENSAMPLERS, GenSamplers)
+DO(DELETESAMPLERS, DeleteSamplers)
+DO(ISSAMPLER, IsSampler)
+DO(BINDSAMPLER, BindSampler)
+DO(SAMPLERPARAMETERI, SamplerParameteri)
+DO(SAMPLERPARAMETERIV, SamplerParameteriv)
+DO(SAMPLERPARAMETERF, SamplerParameterf)
+DO(SAMPLERPARAMETERFV, SamplerParameterfv)
+DO(SAMPLERPARAMETERIIV, SamplerParameterIiv)
+DO(SAMPLERPARAMETERIUIV, SamplerParameterIuiv)
+DO(GETSAMPLERPARAMETERIV, GetSamplerParameteriv)
+DO(GETSAMPLERPARAMETERIIV, GetSamplerParameterIiv)
+DO(GETSAMPLERPARAMETERFV, GetSamplerParameterfv)
+DO(GETSAMPLERPARAMETERIUIV, GetSamplerParameterIuiv)
+DO(QUERYCOUNTER, QueryCounter)
+DO(GETQUERYOBJECTI64V, GetQueryObjecti64v)
+DO(GETQUERYOBJECTUI64V, GetQueryObjectui64v)
+DO(VERTEXATTRIBDIVISOR, VertexAttribDivisor)
+DO(VERTEXATTRIBP1UI, VertexAttribP1ui)
+DO(VERTEXATTRIBP1UIV, VertexAttribP1uiv)
+DO(VERTEXATTRIBP2UI, VertexAttribP2ui)
+DO(VERTEXATTRIBP2UIV, VertexAttribP2uiv)
+DO(VERTEXATTRIBP3UI, VertexAttribP3ui)
+DO(VERTEXATTRIBP3UIV, VertexAttribP3uiv)
+DO(VERTEXATTRIBP4UI, VertexAttribP4ui)
+DO(VERTEXATTRIBP4UIV, VertexAttribP4uiv)
+
+// GL_VERSION_4_1 optional extensions:
+DO_OPTIONAL(GETPROGRAMBINARY, GetProgramBinary)
+DO_OPTIONAL(PROGRAMBINARY, ProgramBinary)
+DO_OPTIONAL(PROGRAMPARAMETERI, ProgramParameteri)
+
+// GL_VERSION_4_4 optional extensions:
+DO_OPTIONAL(BUFFERSTORAGE, BufferStorage)
+
 #endif //GL_SHIMS_HPP
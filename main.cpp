@@ -1,19 +1,99 @@
+#include "BallField.hpp"
 #include "Draw.hpp"
+#include "FixedGame.hpp"
+#include "Game.hpp"
 #include "GL.hpp"
+#include "Latency.hpp"
+#include "Pacing.hpp"
+#include "PerfHud.hpp"
+#include "SimThread.hpp"
 
 #include <SDL.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <ctime>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <string>
+
+#ifdef CHECK_FRAME_ALLOCATIONS
+//Test hook: with AllocationCount.cpp linked, every operator new is counted, so the game loop can
+// check that, once warmed up, frames make no heap allocations. Build with
+// -DCHECK_FRAME_ALLOCATIONS=N (see 'make main_alloc_check') to quit after N frames.
+#include "AllocationCount.hpp"
+#endif
 
 int main(int argc, char **argv) {
+	auto startup_time = std::chrono::high_resolution_clock::now();
+
 	//Configuration:
 	struct {
 		std::string title = "Game0: Tennis For One";
 		glm::uvec2 size = glm::uvec2(800, 640);
+		bool warm_up = true; //exercise Draw offscreen at startup rather than in the first frame (GL objects are created at startup either way)
+		bool program_cache = true; //reuse linked shader programs from earlier runs
+		float sim_step = 1.0f / 240.0f; //seconds per simulation step, independent of display rate
+		uint32_t max_sim_steps = 8; //most steps simulated per frame
+		uint32_t seed = uint32_t(time(0)); //random seed for the game (printed at startup, so a game can be replayed)
+		uint32_t balls = 0; //if nonzero, run the many-ball stress test instead of the game
+		bool fixed_point = false; //simulate with the fixed-point rules (identical on every build)
+		bool late_latch = false; //sleep until just before each vblank, then read input and draw (needs vsync)
+		float late_latch_margin_ms = 2.0f; //head start kept (beyond the expected frame work) when late latching
+		bool vsync = true; //if false (or vsync can't be set), frames are paced to frame_rate by sleeping instead
+		float frame_rate = 60.0f; //target frames per second without vsync
+		bool hud = false; //show the performance overlay from the start (H toggles it)
+		bool sim_thread = false; //step the game on its own thread, independent of the frame rate
+		float sim_rate = 1000.0f; //steps per second on the sim thread
 	} config;
 
+	//Command-line options:
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--no-warm-up") {
+			config.warm_up = false;
+		} else if (arg == "--no-program-cache") {
+			config.program_cache = false;
+		} else if (arg == "--seed" && i + 1 < argc) {
+			config.seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "--balls" && i + 1 < argc) {
+			config.balls = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+			if (config.balls > 100000) {
+				std::cerr << "ERROR: --balls supports at most 100000 balls." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--fixed-point") {
+			config.fixed_point = true;
+		} else if (arg == "--late-latch") {
+			config.late_latch = true;
+		} else if (arg == "--late-latch-margin" && i + 1 < argc) {
+			config.late_latch_margin_ms = float(std::atof(argv[++i]));
+		} else if (arg == "--sim-thread") {
+			config.sim_thread = true;
+		} else if (arg == "--sim-rate" && i + 1 < argc) {
+			config.sim_rate = float(std::atof(argv[++i]));
+			if (!(config.sim_rate > 0.0f)) {
+				std::cerr << "ERROR: --sim-rate must be positive." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--hud") {
+			config.hud = true;
+		} else if (arg == "--no-vsync") {
+			config.vsync = false;
+		} else if (arg == "--frame-rate" && i + 1 < argc) {
+			config.frame_rate = float(std::atof(argv[++i]));
+			if (!(config.frame_rate > 0.0f)) {
+				std::cerr << "ERROR: --frame-rate must be positive." << std::endl;
+				return 1;
+			}
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--no-warm-up] [--no-program-cache] [--seed N] [--balls N] [--fixed-point] [--late-latch] [--late-latch-margin ms] [--no-vsync] [--frame-rate Hz] [--hud] [--sim-thread] [--sim-rate Hz]" << std::endl;
+			return 1;
+		}
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -64,55 +144,276 @@ int main(int argc, char **argv) {
 	#endif
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	if (!config.vsync) {
+		SDL_GL_SetSwapInterval(0);
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
-			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
+			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << "); pacing frames to " << config.frame_rate << " Hz instead." << std::endl;
+			config.vsync = false;
 		}
 	}
+	if (!config.vsync && config.late_latch) {
+		std::cerr << "NOTE: --late-latch needs vsync; ignoring it." << std::endl;
+		config.late_latch = false;
+	}
 
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	SDL_ShowCursor(SDL_DISABLE);
 
+	//Create Draw's GL objects now, and optionally push a draw through each path so the driver finishes its setup before the first frame:
+	//(linked programs are cached in the per-user preferences directory)
+	std::string program_cache_prefix;
+	if (config.program_cache) {
+		char *pref_path = SDL_GetPrefPath("15-466", "Game0");
+		if (pref_path) {
+			program_cache_prefix = pref_path;
+			SDL_free(pref_path);
+		}
+	}
+	std::unique_ptr< DrawContext > draw_context(new DrawContext(program_cache_prefix));
+	std::cout << "Draw programs: " << draw_context->programs_cached << " from cache, "
+	          << draw_context->programs_compiled << " compiled, setup took " << draw_context->setup_ms << "ms." << std::endl;
+	if (config.warm_up) {
+		auto before = std::chrono::high_resolution_clock::now();
+		draw_context->warm_up();
+		auto after = std::chrono::high_resolution_clock::now();
+		std::cout << "Draw warm-up took " << std::chrono::duration< float, std::milli >(after - before).count() << "ms." << std::endl;
+	}
+
+	//------------  retained geometry ------------
+	//nothing drawn below changes shape, so it is recorded once and placed each frame with an offset/scale/tint:
+
+	Draw::Batch square; //white [0,1]x[0,1], used for paddle, ball and target
+	Draw::Batch digits[10]; //white seven-segment digits in a [0,4]x[0,7] cell
+	Draw::Batch win_text, loss_text;
+	{
+		Draw recorder;
+		glm::u8vec4 white = glm::u8vec4(0xff, 0xff, 0xff, 0xff);
+
+		//merge abutting same-color pieces and drop empty ones, keeping count for the log below:
+		recorder.optimize = true;
+		uint32_t rects_in = 0, rects_out = 0;
+		auto record = [&]() -> Draw::Batch {
+			Draw::Batch batch = recorder.record();
+			rects_in += recorder.optimize_stats.rects_in;
+			rects_out += recorder.optimize_stats.rects_out;
+			return batch;
+		};
+
+		recorder.add_rectangle(glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), white);
+		square = record();
+
+		//segments as {min, max} in cell units: top, upper left, upper right, middle, lower left, lower right, bottom
+		glm::vec2 const segments[7][2] = {
+			{glm::vec2(1.0f, 6.0f), glm::vec2(3.0f, 7.0f)},
+			{glm::vec2(0.0f, 4.0f), glm::vec2(1.0f, 6.0f)},
+			{glm::vec2(3.0f, 4.0f), glm::vec2(4.0f, 6.0f)},
+			{glm::vec2(1.0f, 3.0f), glm::vec2(3.0f, 4.0f)},
+			{glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 3.0f)},
+			{glm::vec2(3.0f, 1.0f), glm::vec2(4.0f, 3.0f)},
+			{glm::vec2(1.0f, 0.0f), glm::vec2(3.0f, 1.0f)},
+		};
+		//which segments are lit for each digit (bit i <-> segments[i]):
+		uint8_t const lit[10] = { 0x77, 0x24, 0x5d, 0x6d, 0x2e, 0x6b, 0x7b, 0x25, 0x7f, 0x6f };
+		for (uint32_t d = 0; d < 10; ++d) {
+			for (uint32_t i = 0; i < 7; ++i) {
+				if (lit[d] & (1 << i)) recorder.add_rectangle(segments[i][0], segments[i][1], white);
+			}
+			digits[d] = record();
+		}
+
+		//W
+		recorder.add_rectangle(glm::vec2(-0.45f, 0.3f), glm::vec2(-0.35f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.55f, 0.2f), glm::vec2(-0.45f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.65f, 0.3f), glm::vec2(-0.55f, 0.5f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.75f, 0.2f), glm::vec2(-0.65f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.85f, 0.3f), glm::vec2(-0.75f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+
+		//I
+		recorder.add_rectangle(glm::vec2(-0.25f, 0.6f), glm::vec2(0.25f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.05f, 0.3f), glm::vec2(0.05f, 0.6f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.25f, 0.2f), glm::vec2(0.25f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+
+		//N
+		recorder.add_rectangle(glm::vec2(0.35f, 0.2f), glm::vec2(0.45f, 0.6f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.45f, 0.6f), glm::vec2(0.55f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.55f, 0.3f), glm::vec2(0.65f, 0.6f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.65f, 0.2f), glm::vec2(0.75f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.75f, 0.3f), glm::vec2(0.85f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
+		win_text = record();
+
+		//L
+		recorder.add_rectangle(glm::vec2(-0.87f, 0.2f), glm::vec2(-0.55f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.95f, 0.28f), glm::vec2(-0.87f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+
+		//O
+		recorder.add_rectangle(glm::vec2(-0.37f, 0.2f), glm::vec2(-0.12f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.37f, 0.52f), glm::vec2(-0.12f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.45f, 0.28f), glm::vec2(-0.37f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(-0.12f, 0.28f), glm::vec2(-0.05f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+
+		//S
+		recorder.add_rectangle(glm::vec2(0.13f, 0.2f), glm::vec2(0.37f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.13f, 0.36f), glm::vec2(0.37f, 0.44f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.13f, 0.52f), glm::vec2(0.37f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.05f, 0.44f), glm::vec2(0.13f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.37f, 0.28f), glm::vec2(0.45f, 0.36f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+
+		//S
+		recorder.add_rectangle(glm::vec2(0.63f, 0.2f), glm::vec2(0.87f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.63f, 0.36f), glm::vec2(0.87f, 0.44f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.63f, 0.52f), glm::vec2(0.87f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.55f, 0.44f), glm::vec2(0.63f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		recorder.add_rectangle(glm::vec2(0.87f, 0.28f), glm::vec2(0.95f, 0.36f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
+		loss_text = record();
+
+		std::cout << "Retained geometry: " << rects_in << " rectangles, " << rects_out << " after optimization." << std::endl;
+	}
+
 	//------------  game state ------------
-  int score = 0;
-  int lives = 3;
-
-  // based on https://stackoverflow.com/questions/13445688/how-to-generate-a-random-number-in-c
-  srand((unsigned)time(0));
-  float target_size = 1.2f;
-  float target_y = (rand()/(float)RAND_MAX)*(2.0f - target_size) + target_size/2.0f - 1.0f;
-
-  glm::vec2 target = glm::vec2(-1.0f, target_y);
-	glm::vec2 paddle = glm::vec2(1.0f, 0.0f);
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity;
-  
+	//(the rules live in Game.cpp; main just feeds them input and draws the result)
+	std::cout << "Seed: " << config.seed << " (replay with --seed " << config.seed << ")" << std::endl;
+	GameState state = new_game(config.seed);
+	GameInput input;
+	input.paddle_y = state.paddle.y;
+	glm::vec2 previous_ball = state.ball; //ball before the last simulation step, for interpolation
+	//with --fixed-point, this is the real game state and 'state' is a float copy of it for drawing:
+	FixedGameState fixed_state = new_fixed_game(config.seed);
+	if (config.fixed_point) state = to_game_state(fixed_state);
+
+	//stress test: many balls, stepped in place of the game and drawn through 'draw':
+	std::unique_ptr< BallField > balls;
+	double balls_draw_ms = 0.0; //time spent adding and drawing balls since the last report
+	uint32_t balls_frames = 0;
+	auto balls_report_time = std::chrono::high_resolution_clock::now();
+	if (config.balls) {
+		balls.reset(new BallField(config.balls, config.seed));
+		std::cout << "Stress test: " << balls->count << " balls of radius " << balls->radius << ", "
+		          << balls->cells_per_side << "x" << balls->cells_per_side << " grid." << std::endl;
+	}
+
+	//--sim-thread: the game steps on a SimThread at config.sim_rate; this thread sends it input through a
+	// queue and draws the newest snapshot it published (see SimThread.hpp):
+	std::unique_ptr< SimThread > sim;
+	uint64_t sim_snapshots = 0; //frames that found a new snapshot
+	uint64_t sim_inputs_dropped = 0; //times the input queue was full
+	double sim_motion_ms = 0.0; //newest motion the sim thread reported using
+	double sim_clock_to_ticks_ms = 0.0; //add to FramePacer::now_ms() to get ticks_ms()
+	if (config.sim_thread && balls) {
+		std::cerr << "NOTE: --sim-thread doesn't run the --balls stress test; ignoring it." << std::endl;
+		config.sim_thread = false;
+	}
+
 	//------------  game loop ------------
 
+	//one Draw for the whole game; draw() empties it but keeps its storage:
+	Draw draw;
+	draw.reserve(balls ? balls->count : 1024);
+
+	#ifdef CHECK_FRAME_ALLOCATIONS
+	uint32_t frame = 0;
+	#endif
+
+	//input-to-photon latency: the newest mouse motion's SDL timestamp is followed from the step that
+	// first uses it to the GPU finishing the frame that shows it (see Latency.hpp):
+	LatencyTelemetry latency;
+	//(event timestamps are SDL_GetTicks() milliseconds; this clock has the same origin but finer resolution)
+	double const counter_ms = 1000.0 / double(SDL_GetPerformanceFrequency());
+	double const ticks_offset_ms = double(SDL_GetTicks()) - double(SDL_GetPerformanceCounter()) * counter_ms;
+	auto ticks_ms = [&]() {
+		return double(SDL_GetPerformanceCounter()) * counter_ms + ticks_offset_ms;
+	};
+	bool motion_pending = false; //a motion event not yet seen by a simulation step
+	double motion_ms = 0.0;
+	bool frame_has_motion = false; //this frame's steps saw 'frame_motion_ms'
+	double frame_motion_ms = 0.0;
+	struct GPUPending {
+		GLsync sync;
+		double motion_ms;
+	} gpu_pending[4];
+	uint32_t gpu_pending_count = 0;
+	//record frames the GPU has finished, oldest first:
+	auto poll_gpu = [&]() {
+		while (gpu_pending_count > 0 && glClientWaitSync(gpu_pending[0].sync, 0, 0) != GL_TIMEOUT_EXPIRED) {
+			latency.add(LatencyTelemetry::GPU, float(ticks_ms() - gpu_pending[0].motion_ms));
+			glDeleteSync(gpu_pending[0].sync);
+			std::copy(gpu_pending + 1, gpu_pending + gpu_pending_count, gpu_pending);
+			gpu_pending_count -= 1;
+		}
+	};
+
+	//late latch (--late-latch): sleep until just in time to read input, build the frame, and still make
+	// the next vblank, so the paddle on screen is as fresh as possible:
+	VsyncPredictor vsync_predictor;
+	double frame_work_ms = 0.0; //recent time from waking to calling swap (rises at once, decays slowly)
+	double late_slack_ms = 0.0; //extra head start, added after each missed vblank and slowly given back
+	uint64_t late_missed = 0;
+
+	//without vsync, sleep (then spin briefly) until each frame is due rather than running flat out:
+	FramePacer frame_pacer(config.frame_rate);
+
+	//performance overlay (--hud, or H to toggle): times for each part of the frame, and what was drawn:
+	PerfHud hud;
+	hud.pixel = 2.0f / config.size.y;
+	bool hud_visible = config.hud;
+	//the overlay has its own Draw, merged and culled every frame (the overlay shows how many rectangles that saves):
+	Draw hud_draw;
+	hud_draw.optimize = true;
+	hud_draw.reserve(PerfHud::MaxRectangles);
+	//GPU time per frame, from timer queries read back once they are ready (oldest first, in ring order):
+	GLuint gpu_time_queries[4];
+	glGenQueries(4, gpu_time_queries);
+	uint32_t gpu_time_first = 0, gpu_time_count = 0;
+
+	if (config.sim_thread) {
+		sim_clock_to_ticks_ms = ticks_ms() - FramePacer::now_ms();
+		sim.reset(new SimThread(config.seed, config.sim_rate, config.fixed_point));
+		std::cout << "Sim thread: " << config.sim_rate << " steps per second." << std::endl;
+	}
+	uint64_t render_frames = 0;
+	double render_start_ms = ticks_ms();
+
 	auto previous_time = std::chrono::high_resolution_clock::now();
+	float sim_accumulator = 0.0f; //real time not yet simulated
+	auto first_frame_start = previous_time;
+	bool first_frame = true;
 	bool should_quit = false;
-  bool ball_moving = false;
-  bool game_over = false;
 	while (true) {
+		#ifdef CHECK_FRAME_ALLOCATIONS
+		uint64_t allocations_before = allocation_count();
+		#endif
+
+		if (!config.vsync) frame_pacer.wait();
+
+		double work_start_ms = ticks_ms();
+		if (config.late_latch && vsync_predictor.ready()) {
+			double budget_ms = frame_work_ms + config.late_latch_margin_ms + late_slack_ms;
+			double wake_ms = vsync_predictor.next_vsync_ms(work_start_ms) - budget_ms;
+			//sleep in whole milliseconds (SDL_Delay can oversleep by one), then spin the rest:
+			double remaining_ms = wake_ms - ticks_ms();
+			if (remaining_ms > 2.0) SDL_Delay(uint32_t(remaining_ms - 2.0));
+			while (ticks_ms() < wake_ms) { }
+			work_start_ms = ticks_ms();
+		}
+
 		static SDL_Event evt;
 		while (SDL_PollEvent(&evt) == 1) {
 			//handle input:
 			if (evt.type == SDL_MOUSEMOTION) {
-        if (!game_over) {
-				  paddle.y = (evt.motion.y + 0.5f) / float(config.size.y) *-2.0f + 1.0f;
-        }
+				input.paddle_y = (evt.motion.y + 0.5f) / float(config.size.y) *-2.0f + 1.0f;
+				motion_pending = true;
+				motion_ms = evt.motion.timestamp;
 			} else if (evt.type == SDL_MOUSEBUTTONDOWN) {
-        if (!game_over) {
-          if (!ball_moving) {
-				    ball_velocity = glm::vec2(1.5f, (rand()/(float)RAND_MAX)*3.0f-1.5f); 
-            ball_moving = true;
-          }
-        } else {
-          should_quit = true;
-        }
+				if (!state.game_over) {
+					input.serve = true;
+				} else {
+					should_quit = true;
+				}
 			} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_ESCAPE) {
 				should_quit = true;
+			} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_h) {
+				hud_visible = !hud_visible;
 			} else if (evt.type == SDL_QUIT) {
 				should_quit = true;
 				break;
@@ -120,460 +421,288 @@ int main(int argc, char **argv) {
 		}
 		if (should_quit) break;
 
-		auto current_time = std::chrono::high_resolution_clock::now();
-		float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
-		previous_time = current_time;
-
-		{ //update game state:
-      if (ball_moving) {
-			  ball += elapsed * ball_velocity;
-        
-        //target collision
-        float target_offset = ball.y - target.y;
-        if (ball.x <= -0.94f && std::abs(target_offset) <= (target_size / 2.0f + 0.02f)) {
-          if (++score == 99) {
-            game_over = true;
-          }
-          ball = glm::vec2(0.0f, 0.0f);
-          target_size = std::max(target_size*0.9, 0.05);
-          target_y = (rand()/(float)RAND_MAX)*(2.0f - target_size) + target_size/2.0f - 1.0f;
-          target = glm::vec2(-1.0f, target_y);
-          ball_moving = false;
-        }
- 
-        //paddle collision
-        float paddle_offset = ball.y - paddle.y;
-        if (ball.x >= 0.94f && std::abs(paddle_offset) <= (0.17f)) {
-          ball_velocity.x = -ball_velocity.x;
-          ball_velocity.y = 1.5f * paddle_offset / 0.15f;
-        }
+		DrawCounters counters_before = draw_counters;
+		double update_start_ms = ticks_ms();
+
+		glm::vec2 ball_drawn = state.ball;
+		if (sim) { //--sim-thread: the game steps on its own thread; send it this frame's input and draw its newest state
+			if (motion_pending || input.serve) {
+				SimInput in;
+				in.paddle_y = input.paddle_y;
+				in.serve = input.serve;
+				in.motion_ms = (motion_pending ? motion_ms : 0.0);
+				if (sim->inputs.push(in)) {
+					motion_pending = false;
+					input.serve = false;
+				} else {
+					sim_inputs_dropped += 1; //(try again next frame)
+				}
+			}
+			if (sim->snapshots.update()) sim_snapshots += 1;
+			SimSnapshot const &snapshot = sim->snapshots.read();
+			state = snapshot.state;
+			ball_drawn = state.ball;
+			if (snapshot.motion_ms != sim_motion_ms) {
+				//(the sim thread stamps when it used the input on its own clock, converted here)
+				sim_motion_ms = snapshot.motion_ms;
+				latency.add(LatencyTelemetry::Update, float(snapshot.motion_used_ms + sim_clock_to_ticks_ms - snapshot.motion_ms));
+				frame_has_motion = true;
+				frame_motion_ms = snapshot.motion_ms;
+			}
+		} else {
+			auto current_time = std::chrono::high_resolution_clock::now();
+			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
+			previous_time = current_time;
+
+			//advance the simulation in fixed steps, carrying leftover time into the next frame
+			// (time beyond max_sim_steps is dropped, so one long frame can't snowball):
+			sim_accumulator = std::min(sim_accumulator + elapsed, config.max_sim_steps * config.sim_step);
+			while (sim_accumulator >= config.sim_step) { //update game state:
+				sim_accumulator -= config.sim_step;
+				if (motion_pending) {
+					latency.add(LatencyTelemetry::Update, float(ticks_ms() - motion_ms));
+					motion_pending = false;
+					frame_has_motion = true;
+					frame_motion_ms = motion_ms;
+				}
+				if (balls) {
+					balls->step(config.sim_step);
+					continue;
+				}
+				previous_ball = state.ball;
+				if (config.fixed_point) {
+					FixedGameInput fixed_input;
+					fixed_input.paddle_y = to_fixed(input.paddle_y);
+					fixed_input.serve = input.serve;
+					step(fixed_state, fixed_input, to_fixed(config.sim_step));
+					state = to_game_state(fixed_state);
+				} else {
+					step(state, input, config.sim_step);
+				}
+				input.serve = false;
+				//(the ball only jumps when it is reset, which also stops it; don't interpolate across that)
+				if (!state.ball_moving) previous_ball = state.ball;
+			}
+			//draw between the last two states, by how far the display is into the next step:
+			ball_drawn = glm::mix(previous_ball, state.ball, sim_accumulator / config.sim_step);
+		}
+		double update_ms = ticks_ms() - update_start_ms;
+		double geometry_ms = 0.0, submit_ms = 0.0;
 
-        //wall collision
-        if (ball.x < -1.0f) {
-          ball_velocity.x = std::abs(ball_velocity.x);
-        }
-			  if (ball.x > 1.0f) {
-          if (--lives == 0) {
-            game_over = true;
-          } 
-	        ball = glm::vec2(0.0f, 0.0f);
-          ball_moving = false;
-        }
-        if (ball.y < -1.0f) {
-          ball_velocity.y = std::abs(ball_velocity.y);
-        }
-        if (ball.y > 1.0f) {
-          ball_velocity.y = -std::abs(ball_velocity.y);
-        }
+		//time the frame's GL commands (unless all the queries are still waiting to be read):
+		bool gpu_timing = (gpu_time_count < 4);
+		if (gpu_timing) glBeginQuery(GL_TIME_ELAPSED, gpu_time_queries[(gpu_time_first + gpu_time_count) % 4]);
 
-		  }
-    }
 		//draw output:
 		glClearColor(0.0, 0.0, 0.0, 0.0);
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		{ //draw game state:
-			Draw draw;
-			if (!game_over) {
+		//with --late-latch, read the mouse once more just before building the paddle (the next step uses it too):
+		glm::vec2 paddle_drawn = state.paddle;
+		if (config.late_latch) {
+			int mouse_y = 0;
+			SDL_GetMouseState(nullptr, &mouse_y);
+			float latched_y = (mouse_y + 0.5f) / float(config.size.y) *-2.0f + 1.0f;
+			if (latched_y != input.paddle_y) {
+				//(the paddle on screen now shows input this old, so measure later stages from here)
+				frame_has_motion = true;
+				frame_motion_ms = ticks_ms();
+				if (sim) {
+					SimInput in;
+					in.paddle_y = latched_y;
+					in.motion_ms = frame_motion_ms;
+					if (!sim->inputs.push(in)) sim_inputs_dropped += 1;
+				}
+			}
+			input.paddle_y = latched_y;
+			paddle_drawn.y = latched_y;
+		}
+
+		if (balls) { //draw the stress test's balls:
+			auto draw_before = std::chrono::high_resolution_clock::now();
+			float r = balls->radius;
+			glm::u8vec4 red = glm::u8vec4(0xff, 0x00, 0x00, 0xff);
+			double geometry_start_ms = ticks_ms();
+			for (uint32_t i = 0; i < balls->count; ++i) {
+				glm::vec2 at(balls->x[i], balls->y[i]);
+				draw.add_rectangle(at - glm::vec2(r), at + glm::vec2(r), red);
+			}
+			double submit_start_ms = ticks_ms();
+			draw.draw();
+			geometry_ms += submit_start_ms - geometry_start_ms;
+			submit_ms += ticks_ms() - submit_start_ms;
+			auto draw_after = std::chrono::high_resolution_clock::now();
+			balls_draw_ms += std::chrono::duration< double, std::milli >(draw_after - draw_before).count();
+			balls_frames += 1;
+
+			//once a second, per-phase times per frame (a frame runs several steps):
+			if (std::chrono::duration< float >(draw_after - balls_report_time).count() >= 1.0f) {
+				BallField::Timings &t = balls->timings;
+				double frames = balls_frames;
+				std::cout << "Balls: " << balls_frames << " frames, " << t.steps / frames << " steps/frame; per frame: integrate "
+				          << t.integrate_ms / frames << "ms, grid " << t.grid_ms / frames << "ms, narrowphase "
+				          << t.narrowphase_ms / frames << "ms, draw " << balls_draw_ms / frames << "ms; "
+				          << (t.steps ? t.contacts / t.steps : 0) << " contacts/step from "
+				          << (t.steps ? t.pairs_tested / t.steps : 0) << " pairs tested." << std::endl;
+				t = BallField::Timings();
+				balls_draw_ms = 0.0;
+				balls_frames = 0;
+				balls_report_time = draw_after;
+			}
+		} else { //draw game state (retained batches, so all submit):
+			double submit_start_ms = ticks_ms();
+			glm::u8vec4 red = glm::u8vec4(0xff, 0x00, 0x00, 0xff);
+			glm::u8vec4 green = glm::u8vec4(0x00, 0xff, 0x00, 0xff);
+			glm::u8vec4 blue = glm::u8vec4(0x00, 0x00, 0xff, 0xff);
+			glm::u8vec4 white = glm::u8vec4(0xff, 0xff, 0xff, 0xff);
+			int units = state.score % 10;
+			int tens = state.score / 10;
+			if (!state.game_over) {
         //draw objects
-        draw.add_rectangle(paddle + glm::vec2(-0.04f,-0.15f), paddle + glm::vec2(0.0f, 0.15f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-			  draw.add_rectangle(ball + glm::vec2(-0.02f,-0.02f), ball + glm::vec2(0.02f, 0.02f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-        draw.add_rectangle(target + glm::vec2(0.0f, -target_size/2.0f), target + glm::vec2(0.04f, target_size/2.0f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-       
-        { //draw lives
-          switch (lives) {
-            case 0:
-              draw.add_rectangle(glm::vec2(0.95f, 0.96f), glm::vec2(0.96f, 0.98f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.95f, 0.93f), glm::vec2(0.96f, 0.95f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.92f), glm::vec2(0.98f, 0.93f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.98f, 0.93f), glm::vec2(0.99f, 0.95f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.98f, 0.96f), glm::vec2(0.99f, 0.98f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.98f), glm::vec2(0.98f, 0.99f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              break;
-            case 1:
-              draw.add_rectangle(glm::vec2(0.98f, 0.93f), glm::vec2(0.99f, 0.95f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.98f, 0.96f), glm::vec2(0.99f, 0.98f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              break;
-            case 2:
-              draw.add_rectangle(glm::vec2(0.95f, 0.93f), glm::vec2(0.96f, 0.95f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.92f), glm::vec2(0.98f, 0.93f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.98f, 0.96f), glm::vec2(0.99f, 0.98f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.98f), glm::vec2(0.98f, 0.99f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.95f), glm::vec2(0.98f, 0.96f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              break;
-            case 3:
-              draw.add_rectangle(glm::vec2(0.96f, 0.92f), glm::vec2(0.98f, 0.93f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.98f, 0.93f), glm::vec2(0.99f, 0.95f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.98f, 0.96f), glm::vec2(0.99f, 0.98f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.98f), glm::vec2(0.98f, 0.99f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              draw.add_rectangle(glm::vec2(0.96f, 0.95f), glm::vec2(0.98f, 0.96f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-              break;
-          }
-        }
+        draw.draw(square, paddle_drawn + glm::vec2(-0.04f,-0.15f), glm::vec2(0.04f, 0.3f), blue);
+        draw.draw(square, ball_drawn + glm::vec2(-0.02f,-0.02f), glm::vec2(0.04f, 0.04f), red);
+        draw.draw(square, state.target + glm::vec2(0.0f, -state.target_size/2.0f), glm::vec2(0.04f, state.target_size), green);
 
-        //draw score
-        int units = score % 10;
-        int tens = score / 10;
-
-        { //draw tens
-          switch (tens) {
-            case 0:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.96f), glm::vec2(-0.98f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.99f, 0.93f), glm::vec2(-0.98f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 1:
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 2:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.93f), glm::vec2(-0.98f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 3:
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 4:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.96f), glm::vec2(-0.98f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 5:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.96f), glm::vec2(-0.98f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 6:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.96f), glm::vec2(-0.98f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.99f, 0.93f), glm::vec2(-0.98f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 7:
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 8:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.96f), glm::vec2(-0.98f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.99f, 0.93f), glm::vec2(-0.98f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 9:
-              draw.add_rectangle(glm::vec2(-0.99f, 0.96f), glm::vec2(-0.98f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.92f), glm::vec2(-0.96f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.93f), glm::vec2(-0.95f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.96f, 0.96f), glm::vec2(-0.95f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.98f), glm::vec2(-0.96f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.98f, 0.95f), glm::vec2(-0.96f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-          }
-        }
+        //draw state.lives
+        draw.draw(digits[state.lives], glm::vec2(0.95f, 0.92f), glm::vec2(0.01f, 0.01f), red);
 
-        { //draw units
-          switch (units) {
-            case 0:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.96f), glm::vec2(-0.93f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.94f, 0.93f), glm::vec2(-0.93f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 1:
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 2:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.93f), glm::vec2(-0.93f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 3:
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 4:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.96f), glm::vec2(-0.93f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 5:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.96f), glm::vec2(-0.93f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 6:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.96f), glm::vec2(-0.93f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.94f, 0.93f), glm::vec2(-0.93f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 7:
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 8:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.96f), glm::vec2(-0.93f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.94f, 0.93f), glm::vec2(-0.93f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-            case 9:
-              draw.add_rectangle(glm::vec2(-0.94f, 0.96f), glm::vec2(-0.93f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.92f), glm::vec2(-0.91f, 0.93f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.93f), glm::vec2(-0.90f, 0.95f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.91f, 0.96f), glm::vec2(-0.90f, 0.98f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.98f), glm::vec2(-0.91f, 0.99f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.93f, 0.95f), glm::vec2(-0.91f, 0.96f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break; 
-          }
-        }
-        
+        //draw state.score
+        draw.draw(digits[tens], glm::vec2(-0.99f, 0.92f), glm::vec2(0.01f, 0.01f), blue);
+        draw.draw(digits[units], glm::vec2(-0.94f, 0.92f), glm::vec2(0.01f, 0.01f), blue);
       } else {
-        if (score == 99) {
-          //W
-          draw.add_rectangle(glm::vec2(-0.45f, 0.3f), glm::vec2(-0.35f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.55f, 0.2f), glm::vec2(-0.45f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.65f, 0.3f), glm::vec2(-0.55f, 0.5f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.75f, 0.2f), glm::vec2(-0.65f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.85f, 0.3f), glm::vec2(-0.75f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-
-          //I
-          draw.add_rectangle(glm::vec2(-0.25f, 0.6f), glm::vec2(0.25f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.05f, 0.3f), glm::vec2(0.05f, 0.6f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.25f, 0.2f), glm::vec2(0.25f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-
-          //N
-          draw.add_rectangle(glm::vec2(0.35f, 0.2f), glm::vec2(0.45f, 0.6f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.45f, 0.6f), glm::vec2(0.55f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.55f, 0.3f), glm::vec2(0.65f, 0.6f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.65f, 0.2f), glm::vec2(0.75f, 0.3f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.75f, 0.3f), glm::vec2(0.85f, 0.7f), glm::u8vec4(0x00, 0xff, 0x00, 0xff));
-
+        if (state.score == 99) {
+          draw.draw(win_text, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), white);
         } else {
-          //L
-          draw.add_rectangle(glm::vec2(-0.87f, 0.2f), glm::vec2(-0.55f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.95f, 0.28f), glm::vec2(-0.87f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-
-          //O
-          draw.add_rectangle(glm::vec2(-0.37f, 0.2f), glm::vec2(-0.12f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.37f, 0.52f), glm::vec2(-0.12f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.45f, 0.28f), glm::vec2(-0.37f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(-0.12f, 0.28f), glm::vec2(-0.05f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-
-          //S
-          draw.add_rectangle(glm::vec2(0.13f, 0.2f), glm::vec2(0.37f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.13f, 0.36f), glm::vec2(0.37f, 0.44f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.13f, 0.52f), glm::vec2(0.37f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.05f, 0.44f), glm::vec2(0.13f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.37f, 0.28f), glm::vec2(0.45f, 0.36f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-
-          //S
-          draw.add_rectangle(glm::vec2(0.63f, 0.2f), glm::vec2(0.87f, 0.28f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.63f, 0.36f), glm::vec2(0.87f, 0.44f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.63f, 0.52f), glm::vec2(0.87f, 0.6f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.55f, 0.44f), glm::vec2(0.63f, 0.52f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-          draw.add_rectangle(glm::vec2(0.87f, 0.28f), glm::vec2(0.95f, 0.36f), glm::u8vec4(0xff, 0x00, 0x00, 0xff));
-
-        } 
-        
-        //draw score
-        int units = score % 10;
-        int tens = score / 10;
-
-        { //draw tens
-          switch (tens) {
-            case 0 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.3f), glm::vec2(-0.4f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.5f, -0.6f), glm::vec2(-0.4f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 1 :
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 2 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.6f), glm::vec2(-0.4f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 3 :
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 4 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.3f), glm::vec2(-0.4f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 5 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.3f), glm::vec2(-0.4f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 6 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.3f), glm::vec2(-0.4f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.5f, -0.6f), glm::vec2(-0.4f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 7 :
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 8 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.3f), glm::vec2(-0.4f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.5f, -0.6f), glm::vec2(-0.4f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 9 :
-              draw.add_rectangle(glm::vec2(-0.5f, -0.3f), glm::vec2(-0.4f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.7f), glm::vec2(-0.2f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.6f), glm::vec2(-0.1f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.2f, -0.3f), glm::vec2(-0.1f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.1f), glm::vec2(-0.2f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(-0.4f, -0.4f), glm::vec2(-0.2f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-          }
-        }
-
-        { //draw units
-          switch (units) {
-            case 0 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.3f), glm::vec2(0.2f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.1f, -0.6f), glm::vec2(0.2f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 1 :
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 2 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.6f), glm::vec2(0.2f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 3 :
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 4 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.3f), glm::vec2(0.2f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 5 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.3f), glm::vec2(0.2f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 6 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.3f), glm::vec2(0.2f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.1f, -0.6f), glm::vec2(0.2f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 7 :
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 8 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.3f), glm::vec2(0.2f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.1f, -0.6f), glm::vec2(0.2f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-            case 9 :
-              draw.add_rectangle(glm::vec2(0.1f, -0.3f), glm::vec2(0.2f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.7f), glm::vec2(0.4f, -0.6f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.6f), glm::vec2(0.5f, -0.4f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.4f, -0.3f), glm::vec2(0.5f, -0.1f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.1f), glm::vec2(0.4f, 0.0f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              draw.add_rectangle(glm::vec2(0.2f, -0.4f), glm::vec2(0.4f, -0.3f), glm::u8vec4(0x00, 0x00, 0xff, 0xff));
-              break;
-          }
+          draw.draw(loss_text, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), white);
         }
 
+        //draw state.score
+        draw.draw(digits[tens], glm::vec2(-0.5f, -0.7f), glm::vec2(0.1f, 0.1f), blue);
+        draw.draw(digits[units], glm::vec2(0.1f, -0.7f), glm::vec2(0.1f, 0.1f), blue);
       }
-			
-      draw.draw();
+			submit_ms += ticks_ms() - submit_start_ms;
+		}
+
+		if (hud_visible) { //draw the overlay on top (it shows the frames before this one):
+			double geometry_start_ms = ticks_ms();
+			hud.build(hud_draw);
+			double submit_start_ms = ticks_ms();
+			hud_draw.draw();
+			hud.set_optimize_stats(hud_draw.optimize_stats);
+			geometry_ms += submit_start_ms - geometry_start_ms;
+			submit_ms += ticks_ms() - submit_start_ms;
+		}
+		if (gpu_timing) {
+			glEndQuery(GL_TIME_ELAPSED);
+			gpu_time_count += 1;
 		}
 
+		if (frame_has_motion) {
+			latency.add(LatencyTelemetry::Submit, float(ticks_ms() - frame_motion_ms));
+		}
+
+		double swap_call_ms = ticks_ms();
 		SDL_GL_SwapWindow(window);
+
+		hud.add(PerfHud::Update, float(update_ms));
+		hud.add(PerfHud::Geometry, float(geometry_ms));
+		hud.add(PerfHud::Submit, float(submit_ms));
+		hud.add(PerfHud::SwapWait, float(ticks_ms() - swap_call_ms));
+		hud.set_counts(draw_counters, counters_before);
+		while (gpu_time_count > 0) {
+			GLuint query = gpu_time_queries[gpu_time_first];
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available != GL_TRUE) break;
+			GLuint64 gpu_ns = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpu_ns);
+			hud.add(PerfHud::GPU, float(gpu_ns * 1e-6));
+			gpu_time_first = (gpu_time_first + 1) % 4;
+			gpu_time_count -= 1;
+		}
+
+		if (config.late_latch) {
+			frame_work_ms = std::max(swap_call_ms - work_start_ms, frame_work_ms * 0.98);
+			vsync_predictor.swapped(ticks_ms());
+			if (vsync_predictor.missed > late_missed) {
+				late_missed = vsync_predictor.missed;
+				late_slack_ms = std::min(late_slack_ms + 1.0, vsync_predictor.period_ms() / 2.0);
+			} else {
+				late_slack_ms = std::max(0.0, late_slack_ms - 0.01);
+			}
+		}
+
+		if (frame_has_motion) {
+			latency.add(LatencyTelemetry::Swap, float(ticks_ms() - frame_motion_ms));
+			if (gpu_pending_count < 4) {
+				gpu_pending[gpu_pending_count].sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				gpu_pending[gpu_pending_count].motion_ms = frame_motion_ms;
+				gpu_pending_count += 1;
+			}
+			frame_has_motion = false;
+		}
+		poll_gpu();
+		render_frames += 1;
+
+		if (first_frame) {
+			//first-frame latency, for comparing runs with and without --no-warm-up (which only skips
+			// warm_up(): the GL objects, and the retained batches recorded with them, are still made at
+			// startup, so this isn't the first frame of the old create-on-first-use Draw):
+			auto now = std::chrono::high_resolution_clock::now();
+			std::cout << "First frame took " << std::chrono::duration< float, std::milli >(now - first_frame_start).count() << "ms"
+			          << " (" << std::chrono::duration< float, std::milli >(now - startup_time).count() << "ms after startup"
+			          << (config.warm_up ? ", with warm-up" : ", without warm-up; GL objects were still created at startup") << ")." << std::endl;
+			first_frame = false;
+		}
+
+		#ifdef CHECK_FRAME_ALLOCATIONS
+		{ //the first few frames may allocate (lazy GL setup, driver buffers); after that, none should:
+			uint64_t frame_allocations = allocation_count() - allocations_before;
+			frame += 1;
+			if (frame > 10 && frame_allocations != 0) {
+				std::cerr << "ERROR: frame " << frame << " made " << frame_allocations << " heap allocations." << std::endl;
+				return 1;
+			}
+			if (frame == CHECK_FRAME_ALLOCATIONS) {
+				std::cout << "No heap allocations in frames 11-" << frame << "." << std::endl;
+				break;
+			}
+		}
+		#endif
 	}
 
 
 	//------------  teardown ------------
 
+	glFinish();
+	poll_gpu();
+	latency.print(std::cout);
+	if (sim) {
+		sim->stop();
+		sim->pacer.print(std::cout, "Sim thread");
+		double seconds = (ticks_ms() - render_start_ms) / 1000.0;
+		std::cout << "Render thread: " << render_frames << " frames in " << seconds << "s (" << render_frames / seconds << " Hz); "
+		          << sim_snapshots << " found a new snapshot, " << (render_frames ? double(sim->snapshots.read().steps) / render_frames : 0.0)
+		          << " steps per frame; input queue full " << sim_inputs_dropped << " times." << std::endl;
+	}
+	if (config.late_latch) {
+		std::cout << "Late latch: " << vsync_predictor.swaps << " frames at " << vsync_predictor.period_ms() << "ms, "
+		          << vsync_predictor.missed << " vblanks missed; frame work estimate " << frame_work_ms << "ms, extra slack "
+		          << late_slack_ms << "ms." << std::endl;
+	}
+	if (!config.vsync) {
+		frame_pacer.print(std::cout);
+	}
+
+	glDeleteQueries(4, gpu_time_queries);
+	Draw::release(square);
+	for (auto &digit : digits) {
+		Draw::release(digit);
+	}
+	Draw::release(win_text);
+	Draw::release(loss_text);
+	draw_context.reset();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
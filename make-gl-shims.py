@@ -7,6 +7,9 @@ import re
 protos = []
 extensions = []
 
+#functions from later versions that are used when present, but whose absence isn't an error:
+optional = ['GetProgramBinary', 'ProgramBinary', 'ProgramParameteri', 'BufferStorage']
+
 with open('glcorearb.h', 'r') as f:
 	in_version = None
 	for line in f:
@@ -20,11 +23,12 @@ with open('glcorearb.h', 'r') as f:
 				protos.append("\n// " + in_version + " prototypes:\n")
 				do_proto = True
 				do_extension = False
-			elif (major,minor) < (3,3):
+			elif (major,minor) <= (3,3):
 				extensions.append("\n// " + in_version + " extensions:\n")
 				do_proto = False
 				do_extension = True
 			else:
+				optional_header = "\n// " + in_version + " optional extensions:\n"
 				do_proto = False
 				do_extension = False
 		if in_version:
@@ -35,12 +39,21 @@ with open('glcorearb.h', 'r') as f:
 				pass
 			if do_extension:
 			#	m = re.match(r".* PFNGL([^)]+)PROC\)", line)
-				m = re.match(r"GLAPI .* APIENTRY gl([^ ]+) \(", line)
+				m = re.match(r"GLAPI .*APIENTRY\s*gl([^ ]+) \(", line)
 				if m != None:
 					lc = m.group(1)
 					uc = lc.upper()
 					extensions.append("DO(" + uc + ", " + lc + ")\n")
 				pass
+			if not do_proto and not do_extension:
+				m = re.match(r"GLAPI .*APIENTRY\s*gl([^ ]+) \(", line)
+				if m != None and m.group(1) in optional:
+					if optional_header:
+						extensions.append(optional_header)
+						optional_header = None
+					lc = m.group(1)
+					uc = lc.upper()
+					extensions.append("DO_OPTIONAL(" + uc + ", " + lc + ")\n")
 			m = re.match(r"^#endif /\* " + in_version + " \*/$", line)
 			if m != None:
 				in_version = None
@@ -72,6 +85,11 @@ print("""
 	extern PFNGL ## TYPE ## PROC gl ## NAME;
 #endif
 
+//optional functions are left NULL if the driver doesn't provide them:
+#ifndef DO_OPTIONAL
+#define DO_OPTIONAL(TYPE, NAME) DO(TYPE, NAME)
+#endif
+
 """)
 
 print("".join(extensions))
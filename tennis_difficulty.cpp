@@ -0,0 +1,322 @@
+#include "Game.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//tennis_difficulty measures how hard each stage of Tennis For One is. Stage N
+// is the point played at score N, when the target has shrunk N times. For
+// every stage it plays many single rallies (serve until the point is won or
+// lost) with a scripted paddle policy. The main number is P(hit): how often a
+// return hits the target. The policy's paddle may also miss the ball (at the
+// default speed it never does; lower --paddle-speed to see it), so the
+// report also gives how often it returns the ball, how often the point is
+// won or lost, how many returns that takes, and how long rallies run.
+//
+// Rallies are spread over all cores by a small work-stealing scheduler: each
+// worker owns a deque of rally ranges, splits big ranges in half (keeping
+// the halves on its own deque), works from the back of its deque, and steals
+// from the front of others' when it runs dry. Each rally's randomness comes
+// only from its (stage, index), so results don't depend on thread count.
+
+//----- policies -----
+
+struct Policy {
+	enum Kind {
+		Aim, //return the ball toward the target
+		Track, //just keep the paddle on the ball (returns go straight back)
+	} kind = Aim;
+	float speed = 2.0f; //paddle speed, units per second
+	float aim_error = 0.1f; //each return aims up to this far (uniformly) from where it means to
+};
+
+//64-bit mix (splitmix64 finalizer), used to derive per-rally seeds:
+static uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+//----- results -----
+
+//returns are counted exactly up to this many; longer rallies share the last bucket:
+static const uint32_t MaxReturns = 63;
+
+struct StageResults {
+	uint64_t rallies = 0;
+	uint64_t hits = 0; //target hit (point won)
+	uint64_t misses = 0; //paddle missed (life lost)
+	uint64_t total_returns = 0; //paddle returns (each one an attempt at the target)
+	uint64_t unresolved = 0; //still going after max_steps
+	uint64_t steps = 0;
+	uint64_t returns[MaxReturns + 1] = { };
+
+	void add(StageResults const &o) {
+		rallies += o.rallies;
+		hits += o.hits;
+		misses += o.misses;
+		unresolved += o.unresolved;
+		total_returns += o.total_returns;
+		steps += o.steps;
+		for (uint32_t i = 0; i <= MaxReturns; ++i) returns[i] += o.returns[i];
+	}
+	//smallest return count with at least fraction 'p' of rallies at or below it:
+	uint32_t returns_percentile(double p) const {
+		uint64_t want = uint64_t(p * rallies);
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i <= MaxReturns; ++i) {
+			seen += returns[i];
+			if (seen >= want && seen > 0) return i;
+		}
+		return MaxReturns;
+	}
+};
+
+struct Settings {
+	Policy policy;
+	float step = 1.0f / 240.0f;
+	uint32_t max_steps = 240 * 120; //two minutes per rally
+	uint64_t seed = 1;
+};
+
+//play rally 'index' of 'stage' and add its outcome to 'results':
+static void play_rally(Settings const &settings, int stage, uint64_t index, StageResults &results) {
+	uint64_t h = mix(settings.seed ^ mix((uint64_t(stage) << 40) ^ index));
+	GameState state = new_game(uint32_t(h), uint32_t(h >> 32), stage);
+	//how far the next return will miss its aim by (from its own stream, so the game's randomness is untouched):
+	uint64_t p = mix(h);
+	RandomStream policy_random(uint32_t(p), uint32_t(p >> 32));
+	auto next_aim_offset = [&]() {
+		return (policy_random.next_float() * 2.0f - 1.0f) * settings.policy.aim_error;
+	};
+	float aim_offset = next_aim_offset();
+
+	uint32_t returns = 0;
+	uint32_t steps = 0;
+	GameInput input;
+	input.serve = true;
+	while (steps < settings.max_steps) {
+		float aim_y = state.target.y + aim_offset;
+		if (settings.policy.kind == Policy::Track) aim_y = state.ball.y;
+		input.paddle_y = computer_paddle(state.ball.y, state.paddle.y, aim_y, settings.policy.speed, settings.step);
+
+		bool was_going_right = (state.ball_velocity.x > 0.0f);
+		step(state, input, settings.step);
+		input.serve = false;
+		++steps;
+
+		if (!state.ball_moving) break;
+		if (was_going_right && state.ball_velocity.x < 0.0f) {
+			++returns;
+			aim_offset = next_aim_offset();
+		}
+	}
+
+	results.rallies += 1;
+	results.steps += steps;
+	results.returns[std::min(returns, MaxReturns)] += 1;
+	results.total_returns += returns;
+	if (state.score > stage) results.hits += 1;
+	else if (state.lives < GameState().lives) results.misses += 1;
+	else results.unresolved += 1;
+}
+
+//----- work-stealing scheduler -----
+
+//rallies [begin,end) of one stage:
+struct Task {
+	int stage;
+	uint64_t begin, end;
+};
+
+struct Worker {
+	std::mutex mutex; //guards 'tasks'
+	std::deque< Task > tasks;
+	std::vector< StageResults > results; //indexed by stage
+	uint64_t steals = 0;
+};
+
+//ranges are split until they are at most this many rallies:
+static const uint64_t Grain = 256;
+
+//play 'rallies' rallies of each of 'stages' stages on 'threads' threads:
+static std::vector< StageResults > run(Settings const &settings, int stages, uint64_t rallies, uint32_t threads, uint64_t *steals) {
+	std::vector< std::unique_ptr< Worker > > workers;
+	for (uint32_t t = 0; t < threads; ++t) {
+		workers.emplace_back(new Worker);
+		workers.back()->results.resize(stages);
+	}
+	//deal stages out round-robin; stealing evens out the rest:
+	for (int s = 0; s < stages; ++s) {
+		workers[s % threads]->tasks.push_back(Task{s, 0, rallies});
+	}
+	std::atomic< uint64_t > remaining(uint64_t(stages) * rallies);
+
+	auto work = [&](uint32_t self) {
+		Worker &me = *workers[self];
+		while (remaining.load() > 0) {
+			Task task;
+			bool found = false;
+			{ //newest (smallest) task from own deque:
+				std::lock_guard< std::mutex > lock(me.mutex);
+				if (!me.tasks.empty()) {
+					task = me.tasks.back();
+					me.tasks.pop_back();
+					found = true;
+				}
+			}
+			for (uint32_t i = 1; i < threads && !found; ++i) {
+				//oldest (largest) task from someone else's:
+				Worker &victim = *workers[(self + i) % threads];
+				std::lock_guard< std::mutex > lock(victim.mutex);
+				if (!victim.tasks.empty()) {
+					task = victim.tasks.front();
+					victim.tasks.pop_front();
+					found = true;
+					me.steals += 1;
+				}
+			}
+			if (!found) {
+				//others are still finishing; they may yet split off work:
+				std::this_thread::yield();
+				continue;
+			}
+
+			//keep halves of a big range where thieves can get them:
+			while (task.end - task.begin > Grain) {
+				uint64_t mid = task.begin + (task.end - task.begin) / 2;
+				std::lock_guard< std::mutex > lock(me.mutex);
+				me.tasks.push_back(Task{task.stage, mid, task.end});
+				task.end = mid;
+			}
+			for (uint64_t r = task.begin; r < task.end; ++r) {
+				play_rally(settings, task.stage, r, me.results[task.stage]);
+			}
+			remaining -= task.end - task.begin;
+		}
+	};
+
+	std::vector< std::thread > pool;
+	for (uint32_t t = 1; t < threads; ++t) {
+		pool.emplace_back(work, t);
+	}
+	work(0);
+	for (auto &t : pool) t.join();
+
+	std::vector< StageResults > results(stages);
+	*steals = 0;
+	for (auto const &w : workers) {
+		for (int s = 0; s < stages; ++s) results[s].add(w->results[s]);
+		*steals += w->steals;
+	}
+	return results;
+}
+
+int main(int argc, char **argv) {
+	struct {
+		int stages = 32;
+		uint64_t rallies = 100000; //per stage
+		uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+		uint32_t threads = cores;
+		bool scaling = false;
+	} config;
+	Settings settings;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--stages" && i + 1 < argc) {
+			config.stages = std::max(1, std::min(99, std::atoi(argv[++i])));
+		} else if (arg == "--rallies" && i + 1 < argc) {
+			config.rallies = std::strtoull(argv[++i], nullptr, 10);
+		} else if (arg == "--threads" && i + 1 < argc) {
+			config.threads = std::max(1, std::atoi(argv[++i]));
+		} else if (arg == "--scaling") {
+			config.scaling = true;
+		} else if (arg == "--policy" && i + 1 < argc) {
+			std::string kind = argv[++i];
+			if (kind == "aim") settings.policy.kind = Policy::Aim;
+			else if (kind == "track") settings.policy.kind = Policy::Track;
+			else {
+				std::cerr << "Unknown policy '" << kind << "' (expected 'aim' or 'track')." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--paddle-speed" && i + 1 < argc) {
+			settings.policy.speed = float(std::atof(argv[++i]));
+		} else if (arg == "--aim-error" && i + 1 < argc) {
+			settings.policy.aim_error = float(std::atof(argv[++i]));
+		} else if (arg == "--step" && i + 1 < argc) {
+			settings.step = float(std::atof(argv[++i]));
+		} else if (arg == "--seed" && i + 1 < argc) {
+			settings.seed = std::strtoull(argv[++i], nullptr, 10);
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--stages N] [--rallies N] [--threads N] [--scaling]"
+			          << " [--policy aim|track] [--paddle-speed units/s] [--aim-error units] [--step seconds] [--seed N]" << std::endl;
+			return 1;
+		}
+	}
+
+	//thread counts to time: just the one asked for, or (with --scaling) 1, 2, 4, ... up to it:
+	std::vector< uint32_t > thread_counts;
+	if (config.scaling) {
+		for (uint32_t t = 1; t < config.threads; t *= 2) thread_counts.emplace_back(t);
+	}
+	thread_counts.emplace_back(config.threads);
+	if (config.scaling) {
+		std::cout << "Timing 1 to " << config.threads << " threads on " << config.cores << " core" << (config.cores == 1 ? "" : "s")
+		          << " (threads beyond the core count share cores, so can't speed things up)." << std::endl;
+	}
+
+	std::vector< StageResults > results;
+	double one_thread_seconds = 0.0;
+	for (uint32_t threads : thread_counts) {
+		uint64_t steals = 0;
+		auto before = std::chrono::high_resolution_clock::now();
+		results = run(settings, config.stages, config.rallies, threads, &steals);
+		auto after = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration< double >(after - before).count();
+		if (threads == 1) one_thread_seconds = seconds;
+
+		uint64_t total = uint64_t(config.stages) * config.rallies;
+		std::cout << threads << " thread" << (threads == 1 ? "" : "s") << ": " << total << " rallies in "
+		          << std::fixed << std::setprecision(3) << seconds << "s (" << std::setprecision(0) << total / seconds << " rallies/s, "
+		          << steals << " steals)";
+		if (one_thread_seconds > 0.0) {
+			std::cout << ", speedup " << std::setprecision(2) << one_thread_seconds / seconds
+			          << " (" << std::setprecision(0) << 100.0 * one_thread_seconds / seconds / threads << "% of linear)";
+		}
+		if (threads > config.cores) std::cout << " [more threads than cores]";
+		std::cout << "." << std::endl;
+	}
+
+	std::cout << std::endl;
+	//P(hit) is per return (each return is one attempt at the target); P(return) is per ball reaching
+	// the paddle; won, lost and unresolved are per rally:
+	std::cout << std::setw(5) << "stage" << std::setw(8) << "size"
+	          << std::setw(9) << "P(hit)" << std::setw(11) << "P(return)"
+	          << std::setw(8) << "won" << std::setw(8) << "lost" << std::setw(11) << "unresolved"
+	          << std::setw(9) << "returns:" << std::setw(6) << "mean" << std::setw(5) << "p50" << std::setw(5) << "p90" << std::setw(5) << "p99"
+	          << std::setw(11) << "seconds" << std::endl;
+	for (int s = 0; s < config.stages; ++s) {
+		StageResults const &r = results[s];
+		double n = double(std::max< uint64_t >(r.rallies, 1));
+		double returns = double(r.total_returns);
+		std::cout << std::setw(5) << s << std::setw(8) << std::setprecision(3) << target_size_at(s)
+		          << std::setw(9) << r.hits / std::max(returns, 1.0) << std::setw(11) << returns / std::max(returns + r.misses, 1.0)
+		          << std::setw(8) << r.hits / n << std::setw(8) << r.misses / n << std::setw(11) << r.unresolved / n
+		          << std::setw(9) << "" << std::setw(6) << std::setprecision(2) << returns / n
+		          << std::setw(5) << r.returns_percentile(0.5) << std::setw(5) << r.returns_percentile(0.9) << std::setw(5) << r.returns_percentile(0.99)
+		          << std::setw(11) << std::setprecision(2) << r.steps * settings.step / n << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,596 @@
+#include "FixedGame.hpp"
+#include "Game.hpp"
+#include "GameBatch.hpp"
+#include "Pacing.hpp"
+#include "Predict.hpp"
+#include "SimThread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//tennis_sim plays many games of Tennis For One headlessly (no window, no GL),
+// with a simple computer player that serves immediately and moves the paddle
+// (at a limited speed) to return the ball toward the target. It reports the
+// outcomes and how many simulation steps per second the game code runs at.
+//
+// With --batch the games are run together through GameBatch (SIMD); with
+// --verify they are run through both GameBatch::step() and the one-at-a-time
+// step(), checking after every step that the two agree exactly.
+//
+// With --events each game is played contact to contact (see next_contact()):
+// the ball is never stepped, and the computer player's per-step paddle moves
+// between contacts are computed in closed form (computer_paddle_steps()), so
+// it plays statistically the same game as the default mode, though rounding
+// makes individual games differ. --cross-check plays random points both ways
+// and checks that every contact happens in the same place at the same time.
+//
+// --predict checks predict_crossing() against the contact-to-contact sim and
+// times it, one query at a time and in batches.
+//
+// --fixed plays the games with the fixed-point rules (FixedGame.hpp) as well as
+// the float ones, comparing throughput, and replays them on several threads to
+// check that every game comes out bit-for-bit the same.
+//
+// --pace runs a frame loop held to --pace-hz by FramePacer (Pacing.hpp), each
+// frame stepping every game once, and reports how evenly the frames started.
+//
+// --threaded plays one game on a SimThread at --sim-rate while a stand-in
+// render loop at --pace-hz reads its snapshots and sends the computer player's
+// input back, reporting both threads' rates separately. --render-stall makes
+// every 30th render frame sleep, to show the sim keeps its rate regardless.
+
+//the computer player's input for every game in 'batch'; returns how many games are still going:
+static uint32_t computer_inputs(GameBatch &batch, float speed, float dt) {
+	uint32_t playing = 0;
+	for (uint32_t i = 0; i < batch.count; ++i) {
+		batch.input_paddle_y[i] = computer_paddle(batch.ball_y[i], batch.paddle_y[i], batch.target_y[i], speed, dt);
+		batch.input_serve[i] = 1;
+		playing += (batch.game_over[i] == 0);
+	}
+	return playing;
+}
+
+//play 'state' to the end contact by contact: the ball jumps straight to each surface, while the
+// computer player sees what it would when stepped by 'dt' -- at every step boundary it moves the
+// paddle (by computer_paddle()) toward the ball as it is then, and each point is served at a
+// boundary. The ball's y is linear between contacts, so the paddle's moves up to each contact are
+// taken in one go by computer_paddle_steps(). That agrees with stepping up to float rounding, which
+// paddle returns magnify, so games come out statistically the same as in the default mode rather
+// than identical. Returns the number of contacts:
+static uint64_t play_events(GameState &state, float speed, float dt, uint64_t max_contacts) {
+	float phase = 0.0f; //time since the last step boundary
+	uint64_t contacts = 0;
+	while (!state.game_over && contacts < max_contacts) {
+		if (!state.ball_moving) {
+			//(a point ends its step, so the next one starts at a boundary, as in step())
+			state.paddle.y = computer_paddle(state.ball.y, state.paddle.y, state.target.y, speed, dt);
+			serve(state);
+			phase = 0.0f;
+		}
+		BallContact contact = next_contact(state);
+		//the boundaries before the contact, each seeing the ball on its way there:
+		float first = dt - phase;
+		if (first < contact.time) {
+			uint64_t boundaries = uint64_t(std::ceil((contact.time - first) / dt));
+			float ball_y = state.ball.y + first * state.ball_velocity.y;
+			state.paddle.y = computer_paddle_steps(ball_y, state.ball_velocity.y, state.paddle.y, state.target.y, speed, dt, boundaries);
+		}
+		phase = std::fmod(phase + contact.time, dt);
+		state.ball += contact.time * state.ball_velocity;
+		resolve_contact(state, contact);
+		++contacts;
+	}
+	return contacts;
+}
+
+//advance 'state' by exactly 'time' seconds, contact to contact (the paddle stays where it is):
+static void advance_events(GameState &state, float time) {
+	while (state.ball_moving) {
+		BallContact contact = next_contact(state);
+		if (contact.time > time) break;
+		time -= advance_to_contact(state);
+	}
+	if (state.ball_moving) state.ball += time * state.ball_velocity;
+}
+
+//Play one point from 'start' (ball moving, paddle held still) for up to 'max_contacts' contacts,
+// checking each contact: predict it from the stepped state, step through it, and compare. (Checking
+// from the stepped state each time keeps rounding differences from growing -- each paddle return
+// magnifies them tenfold.) Contacts within 'margin' of a paddle or target edge, or of a step
+// boundary, can legitimately go either way and are counted in 'borderline' instead.
+// Returns false on the first contact where the two disagree:
+static bool cross_check_point(GameState const &start, float dt, uint32_t max_contacts, float margin, uint32_t *checked, uint32_t *borderline) {
+	GameState stepped = start;
+	GameInput input;
+	input.paddle_y = start.paddle.y;
+	for (uint32_t c = 0; c < max_contacts && stepped.ball_moving; ++c) {
+		BallContact contact = next_contact(stepped);
+		//the contact happens during step 'steps':
+		float steps_f = contact.time / dt;
+		uint32_t steps = uint32_t(steps_f) + 1;
+		bool near_edge = std::abs(steps_f - std::floor(steps_f + 0.5f)) < margin;
+		float y = stepped.ball.y + contact.time * stepped.ball_velocity.y;
+		if (contact.surface == BallContact::Paddle) {
+			near_edge |= (std::abs(std::abs(y - stepped.paddle.y) - 0.17f) < margin);
+		} else if (contact.surface == BallContact::Target) {
+			near_edge |= (std::abs(std::abs(y - stepped.target.y) - (stepped.target_size / 2.0f + 0.02f)) < margin);
+		}
+
+		GameState predicted = stepped;
+		advance_events(predicted, steps * dt);
+		for (uint32_t s = 0; s < steps; ++s) {
+			step(stepped, input, dt);
+		}
+
+		auto close = [](glm::vec2 const &a, glm::vec2 const &b) {
+			return std::abs(a.x - b.x) < 1e-4f && std::abs(a.y - b.y) < 1e-4f;
+		};
+		bool same = predicted.score == stepped.score && predicted.lives == stepped.lives && predicted.ball_moving == stepped.ball_moving
+		         && close(predicted.ball, stepped.ball) && close(predicted.ball_velocity, stepped.ball_velocity);
+		if (near_edge) {
+			*borderline += 1;
+		} else if (!same) {
+			return false;
+		} else {
+			*checked += 1;
+		}
+	}
+	return true;
+}
+
+//play fixed-point game 'g' to the end with the computer player; returns the steps taken:
+static uint64_t play_fixed(FixedGameState &state, Fixed speed, Fixed dt, uint64_t max_steps) {
+	uint64_t steps = 0;
+	while (!state.game_over && steps < max_steps) {
+		FixedGameInput input;
+		input.paddle_y = computer_paddle(state.ball_y, state.paddle_y, state.target_y, speed, dt);
+		input.serve = true;
+		step(state, input, dt);
+		++steps;
+	}
+	return steps;
+}
+
+static bool same_fixed(FixedGameState const &a, FixedGameState const &b) {
+	return a.score == b.score && a.lives == b.lives && a.target_size == b.target_size && a.target_y == b.target_y
+	    && a.paddle_y == b.paddle_y && a.ball_x == b.ball_x && a.ball_y == b.ball_y
+	    && a.velocity_x == b.velocity_x && a.velocity_y == b.velocity_y
+	    && a.ball_moving == b.ball_moving && a.game_over == b.game_over && a.random.position == b.random.position;
+}
+
+//true if every game in 'a' and 'b' is in exactly the same state:
+static bool same_games(GameBatch const &a, GameBatch const &b, uint32_t *first_difference) {
+	for (uint32_t i = 0; i < a.count; ++i) {
+		GameState sa = a.get(i);
+		GameState sb = b.get(i);
+		if (std::memcmp(&a.ball_x[i], &b.ball_x[i], 4) || std::memcmp(&a.ball_y[i], &b.ball_y[i], 4)
+		 || std::memcmp(&a.velocity_x[i], &b.velocity_x[i], 4) || std::memcmp(&a.velocity_y[i], &b.velocity_y[i], 4)
+		 || std::memcmp(&a.paddle_y[i], &b.paddle_y[i], 4)
+		 || std::memcmp(&a.target_y[i], &b.target_y[i], 4) || std::memcmp(&a.target_size[i], &b.target_size[i], 4)
+		 || sa.score != sb.score || sa.lives != sb.lives
+		 || sa.ball_moving != sb.ball_moving || sa.game_over != sb.game_over
+		 || sa.random.seed != sb.random.seed || sa.random.stream != sb.random.stream || sa.random.position != sb.random.position) {
+			*first_difference = i;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	struct {
+		uint32_t games = 1000;
+		float step = 1.0f / 240.0f; //seconds per simulation step
+		float paddle_speed = 2.0f; //computer player's paddle speed, units per second
+		uint32_t seed = 1;
+		uint64_t max_steps = 10000000; //per game, in case a game never ends
+		float pace_hz = 60.0f; //--pace: target frame rate
+		uint32_t pace_frames = 600; //--pace: frames to run
+		float pace_spin_ms = 1.0f; //--pace: spin (rather than sleep) this long before each frame
+		float sim_rate = 1000.0f; //--threaded: steps per second on the sim thread
+		float render_stall_ms = 0.0f; //--threaded: extra time taken by every 30th render frame
+		enum { Single, Batch, Verify, Events, CrossCheck, Predict, FixedPoint, Pace, Threaded } mode = Single;
+	} config;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--games" && i + 1 < argc) {
+			config.games = std::atoi(argv[++i]);
+		} else if (arg == "--step" && i + 1 < argc) {
+			config.step = float(std::atof(argv[++i]));
+		} else if (arg == "--paddle-speed" && i + 1 < argc) {
+			config.paddle_speed = float(std::atof(argv[++i]));
+		} else if (arg == "--seed" && i + 1 < argc) {
+			config.seed = std::atoi(argv[++i]);
+		} else if (arg == "--batch") {
+			config.mode = config.Batch;
+		} else if (arg == "--verify") {
+			config.mode = config.Verify;
+		} else if (arg == "--events") {
+			config.mode = config.Events;
+		} else if (arg == "--cross-check") {
+			config.mode = config.CrossCheck;
+		} else if (arg == "--predict") {
+			config.mode = config.Predict;
+		} else if (arg == "--fixed") {
+			config.mode = config.FixedPoint;
+		} else if (arg == "--pace") {
+			config.mode = config.Pace;
+		} else if (arg == "--pace-hz" && i + 1 < argc) {
+			config.pace_hz = float(std::atof(argv[++i]));
+		} else if (arg == "--pace-frames" && i + 1 < argc) {
+			config.pace_frames = std::atoi(argv[++i]);
+		} else if (arg == "--pace-spin" && i + 1 < argc) {
+			config.pace_spin_ms = float(std::atof(argv[++i]));
+		} else if (arg == "--threaded") {
+			config.mode = config.Threaded;
+		} else if (arg == "--sim-rate" && i + 1 < argc) {
+			config.sim_rate = float(std::atof(argv[++i]));
+		} else if (arg == "--render-stall" && i + 1 < argc) {
+			config.render_stall_ms = float(std::atof(argv[++i]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--games N] [--step seconds] [--paddle-speed units/s] [--seed N] [--batch | --verify | --events | --cross-check | --predict | --fixed | --pace [--pace-hz Hz] [--pace-frames N] [--pace-spin ms] | --threaded [--sim-rate Hz] [--render-stall ms]]" << std::endl;
+			return 1;
+		}
+	}
+
+	if (config.mode == config.Verify) {
+		//the bulk generator should give the same draws as stepping a stream, from any start:
+		std::vector< uint32_t > bulk(1001);
+		for (uint64_t start : { uint64_t(0), uint64_t(3), uint64_t(0xfffffffe) }) {
+			random_fill(config.seed, 7, start, bulk.data(), bulk.size());
+			RandomStream stream(config.seed, 7, start);
+			for (uint32_t i = 0; i < bulk.size(); ++i) {
+				if (bulk[i] != stream.next()) {
+					std::cerr << "ERROR: random_fill() differs from RandomStream at draw " << start + i << "." << std::endl;
+					return 1;
+				}
+			}
+		}
+		std::cout << "random_fill() matched RandomStream." << std::endl;
+	}
+
+	if (config.mode == config.CrossCheck) {
+		//random points: ball anywhere in the court heading either way, target and paddle anywhere:
+		RandomStream random(config.seed, 0);
+		float const margin = 1e-3f;
+		uint32_t checked = 0, borderline = 0;
+		for (uint32_t g = 0; g < config.games; ++g) {
+			GameState start = new_game(config.seed, g + 1, int(random.next() % 40));
+			start.ball = glm::vec2(random.next_float() * 1.8f - 0.9f, random.next_float() * 2.0f - 1.0f);
+			start.ball_velocity = glm::vec2((random.next() & 1) ? 1.5f : -1.5f, random.next_float() * 3.4f - 1.7f);
+			start.ball_moving = true;
+			start.paddle.y = random.next_float() * 2.0f - 1.0f;
+			if (!cross_check_point(start, config.step, 64, margin, &checked, &borderline)) {
+				std::cerr << "ERROR: point " << g << " goes differently when stepped and when played contact to contact." << std::endl;
+				return 1;
+			}
+		}
+		std::cout << config.games << " points: " << checked << " contacts agree between stepping and contact-to-contact ("
+		          << borderline << " within " << margin << " of an edge or step boundary not compared)." << std::endl;
+		return 0;
+	}
+
+	if (config.mode == config.Predict) {
+		//random balls heading for the paddle or target face, some steep enough to bounce many times:
+		RandomStream random(config.seed, 0);
+		uint32_t count = std::max(config.games, 4u);
+		std::vector< float > x(count), y(count), vx(count), vy(count), plane(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			x[i] = random.next_float() * 1.8f - 0.9f;
+			y[i] = random.next_float() * 2.0f - 1.0f;
+			vx[i] = (random.next() & 1) ? 1.5f : -1.5f;
+			vy[i] = (random.next_float() * 2.0f - 1.0f) * ((random.next() & 1) ? 1.7f : 20.0f);
+			plane[i] = (vx[i] > 0.0f ? 0.94f : -0.94f);
+		}
+
+		//check against the contact-to-contact sim, stopping (before resolving) at the face:
+		float worst = 0.0f;
+		for (uint32_t i = 0; i < count; ++i) {
+			GameState state;
+			state.ball = glm::vec2(x[i], y[i]);
+			state.ball_velocity = glm::vec2(vx[i], vy[i]);
+			state.ball_moving = true;
+			float time = 0.0f;
+			while (true) {
+				BallContact contact = next_contact(state);
+				if (contact.surface == BallContact::Paddle || contact.surface == BallContact::Target) {
+					time += contact.time;
+					state.ball += contact.time * state.ball_velocity;
+					break;
+				}
+				time += advance_to_contact(state);
+			}
+			Crossing c = predict_crossing(glm::vec2(x[i], y[i]), glm::vec2(vx[i], vy[i]), plane[i]);
+			float error = std::max(std::abs(c.time - time), std::abs(c.y - state.ball.y));
+			if (!(error < 1e-3f) || c.velocity_y != state.ball_velocity.y) {
+				std::cerr << "ERROR: ball " << i << " predicted to cross at y = " << c.y << " after " << c.time
+				          << "s, but reached it at y = " << state.ball.y << " after " << time << "s." << std::endl;
+				return 1;
+			}
+			worst = std::max(worst, error);
+		}
+		std::cout << count << " predictions match the contact-to-contact sim (largest difference " << worst << ")." << std::endl;
+
+		//one query at a time, then in batches (all toward the paddle face, for the batch API):
+		std::vector< float > time(count), cross_y(count), cross_vy(count);
+		uint32_t const repeats = std::max(1u, 10000000u / count);
+		double sum = 0.0;
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t r = 0; r < repeats; ++r) {
+			for (uint32_t i = 0; i < count; ++i) {
+				sum += predict_crossing(glm::vec2(x[i], y[i]), glm::vec2(vx[i], vy[i]), 0.94f).y;
+			}
+		}
+		auto middle = std::chrono::high_resolution_clock::now();
+		for (uint32_t r = 0; r < repeats; ++r) {
+			predict_crossings(count, 0.94f, x.data(), y.data(), vx.data(), vy.data(), time.data(), cross_y.data(), cross_vy.data());
+			sum += cross_y[r % count];
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		double queries = double(repeats) * count;
+		for (uint32_t i = 0; i < count; ++i) {
+			Crossing c = predict_crossing(glm::vec2(x[i], y[i]), glm::vec2(vx[i], vy[i]), 0.94f);
+			if (!(c.time == time[i] && c.y == cross_y[i] && c.velocity_y == cross_vy[i])) {
+				std::cerr << "ERROR: predict_crossings() differs from predict_crossing() for ball " << i << "." << std::endl;
+				return 1;
+			}
+		}
+		std::cout << "predict_crossing(): " << std::chrono::duration< double, std::nano >(middle - before).count() / queries << "ns per query; "
+		          << "predict_crossings(): " << std::chrono::duration< double, std::nano >(after - middle).count() / queries << "ns per query"
+		          << " (checksum " << sum << ")." << std::endl;
+		return 0;
+	}
+
+	if (config.mode == config.Pace) {
+		if (!(config.pace_hz > 0.0f)) {
+			std::cerr << "ERROR: --pace-hz must be positive." << std::endl;
+			return 1;
+		}
+		//a stand-in for a frame's work: every game steps once (finished games start over):
+		std::vector< GameState > games(config.games);
+		for (uint32_t g = 0; g < config.games; ++g) {
+			games[g] = new_game(config.seed, g);
+		}
+		FramePacer pacer(config.pace_hz, config.pace_spin_ms);
+		double work_ms = 0.0;
+		for (uint32_t f = 0; f < config.pace_frames; ++f) {
+			pacer.wait();
+			double work_start_ms = FramePacer::now_ms();
+			for (uint32_t g = 0; g < config.games; ++g) {
+				GameState &state = games[g];
+				if (state.game_over) state = new_game(config.seed, g);
+				GameInput input;
+				input.paddle_y = computer_paddle(state.ball.y, state.paddle.y, state.target.y, config.paddle_speed, config.step);
+				input.serve = true;
+				step(state, input, config.step);
+			}
+			work_ms += FramePacer::now_ms() - work_start_ms;
+		}
+		pacer.print(std::cout);
+		std::cout << "  (work " << (config.pace_frames ? work_ms / config.pace_frames : 0.0) << "ms/frame: " << config.games << " games stepped.)" << std::endl;
+		return 0;
+	}
+
+	if (config.mode == config.Threaded) {
+		if (!(config.pace_hz > 0.0f) || !(config.sim_rate > 0.0f)) {
+			std::cerr << "ERROR: --pace-hz and --sim-rate must be positive." << std::endl;
+			return 1;
+		}
+		SimThread sim(config.seed, config.sim_rate);
+		FramePacer render(config.pace_hz, config.pace_spin_ms);
+		float const render_dt = 1.0f / config.pace_hz;
+		uint32_t frames = 0, fresh = 0, dropped = 0, out_of_order = 0;
+		uint64_t last_steps = 0;
+		for (; frames < config.pace_frames; ++frames) {
+			render.wait();
+			if (sim.snapshots.update()) {
+				fresh += 1;
+				if (sim.snapshots.read().steps < last_steps) out_of_order += 1;
+				last_steps = sim.snapshots.read().steps;
+			}
+			GameState const &state = sim.snapshots.read().state;
+			if (state.game_over) break;
+
+			SimInput in;
+			in.paddle_y = computer_paddle(state.ball.y, state.paddle.y, state.target.y, config.paddle_speed, render_dt);
+			in.serve = true;
+			if (!sim.inputs.push(in)) dropped += 1;
+
+			if (config.render_stall_ms > 0.0f && frames % 30 == 29) {
+				std::this_thread::sleep_for(std::chrono::duration< float, std::milli >(config.render_stall_ms));
+			}
+		}
+		sim.stop();
+		GameState const &final_state = sim.snapshots.read().state;
+		sim.pacer.print(std::cout, "Sim thread");
+		render.print(std::cout, "Render thread");
+		std::cout << fresh << " of " << frames << " render frames saw a new snapshot, " << (frames ? double(last_steps) / frames : 0.0)
+		          << " steps per frame; " << dropped << " inputs dropped (queue full), " << out_of_order << " snapshots out of order; score "
+		          << final_state.score << ", lives " << final_state.lives << "." << std::endl;
+		return (out_of_order == 0 ? 0 : 1);
+	}
+
+	if (config.mode == config.FixedPoint) {
+		typedef std::chrono::high_resolution_clock Clock;
+		auto seconds_since = [](Clock::time_point t) { return std::chrono::duration< double >(Clock::now() - t).count(); };
+
+		//the float rules, for comparison (as the default mode):
+		uint64_t float_steps = 0;
+		auto before = Clock::now();
+		for (uint32_t g = 0; g < config.games; ++g) {
+			GameState state = new_game(config.seed, g);
+			while (!state.game_over && float_steps < config.max_steps * config.games) {
+				GameInput input;
+				input.paddle_y = computer_paddle(state.ball.y, state.paddle.y, state.target.y, config.paddle_speed, config.step);
+				input.serve = true;
+				step(state, input, config.step);
+				++float_steps;
+			}
+		}
+		double float_seconds = seconds_since(before);
+
+		//fixed point, on one thread:
+		Fixed const dt = to_fixed(config.step);
+		Fixed const speed = to_fixed(config.paddle_speed);
+		std::vector< FixedGameState > results(config.games);
+		uint64_t fixed_steps = 0;
+		uint32_t wins = 0;
+		uint64_t total_score = 0;
+		before = Clock::now();
+		for (uint32_t g = 0; g < config.games; ++g) {
+			results[g] = new_fixed_game(config.seed, g);
+			fixed_steps += play_fixed(results[g], speed, dt, config.max_steps);
+			wins += (results[g].score == 99);
+			total_score += results[g].score;
+		}
+		double fixed_seconds = seconds_since(before);
+
+		//again, with games dealt out round-robin to several threads:
+		uint32_t threads = std::max(2u, std::thread::hardware_concurrency());
+		std::vector< FixedGameState > threaded(config.games);
+		std::vector< std::thread > workers;
+		for (uint32_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t]() {
+				for (uint32_t g = t; g < config.games; g += threads) {
+					threaded[g] = new_fixed_game(config.seed, g);
+					play_fixed(threaded[g], speed, dt, config.max_steps);
+				}
+			});
+		}
+		for (auto &worker : workers) worker.join();
+		for (uint32_t g = 0; g < config.games; ++g) {
+			if (!same_fixed(results[g], threaded[g])) {
+				std::cerr << "ERROR: fixed-point game " << g << " came out differently on " << threads << " threads." << std::endl;
+				return 1;
+			}
+		}
+
+		//(a checksum of every final state, for comparing builds: it should never change)
+		uint64_t checksum = 14695981039346656037ull;
+		for (auto const &s : results) {
+			int64_t fields[] = { s.score, s.lives, s.target_size, s.target_y, s.paddle_y, s.ball_x, s.ball_y, s.velocity_x, s.velocity_y, int64_t(s.random.position) };
+			for (int64_t f : fields) checksum = (checksum ^ uint64_t(f)) * 1099511628211ull;
+		}
+
+		std::cout << config.games << " fixed-point games, " << wins << " won, mean score "
+		          << (config.games ? double(total_score) / config.games : 0.0) << "; identical on 1 and " << threads << " threads"
+		          << " (checksum " << std::hex << checksum << std::dec << ")." << std::endl;
+		std::cout << "float: " << float_steps / float_seconds << " steps/s; fixed point: " << fixed_steps / fixed_seconds << " steps/s ("
+		          << (fixed_steps / fixed_seconds) / (float_steps / float_seconds) << "x)." << std::endl;
+		return 0;
+	}
+
+	uint64_t steps = 0;
+	uint64_t contacts = 0;
+	uint32_t wins = 0;
+	uint32_t unfinished = 0;
+	uint64_t total_score = 0;
+
+	auto before = std::chrono::high_resolution_clock::now();
+	if (config.mode == config.Single) {
+		for (uint32_t g = 0; g < config.games; ++g) {
+			GameState state = new_game(config.seed, g);
+			uint64_t game_steps = 0;
+			while (!state.game_over && game_steps < config.max_steps) {
+				GameInput input;
+				input.paddle_y = computer_paddle(state.ball.y, state.paddle.y, state.target.y, config.paddle_speed, config.step);
+				input.serve = true;
+				step(state, input, config.step);
+				++game_steps;
+			}
+			steps += game_steps;
+			if (!state.game_over) unfinished += 1;
+			if (state.score == 99) wins += 1;
+			total_score += state.score;
+		}
+	} else if (config.mode == config.Events) {
+		for (uint32_t g = 0; g < config.games; ++g) {
+			GameState state = new_game(config.seed, g);
+			contacts += play_events(state, config.paddle_speed, config.step, config.max_steps);
+			if (!state.game_over) unfinished += 1;
+			if (state.score == 99) wins += 1;
+			total_score += state.score;
+		}
+	} else {
+		//games run in up to 4096 lanes; when a lane's game ends the next game starts in it:
+		uint32_t lanes = std::min(config.games, 4096u);
+		GameBatch batch(lanes, config.seed);
+		//(for --verify, a copy stepped one game at a time)
+		GameBatch reference(config.mode == config.Verify ? lanes : 0, config.seed);
+		uint32_t next_game = lanes;
+		std::vector< bool > retired(lanes, false);
+		unfinished = lanes;
+
+		//time spent in GameBatch::step() alone; it steps every lane (padding and finished games too),
+		// but only steps of games still going count as useful work:
+		double step_seconds = 0.0;
+		uint64_t lane_steps = 0, live_steps = 0;
+
+		for (uint64_t s = 0; s < config.max_steps && unfinished > 0; ++s) {
+			uint32_t live = computer_inputs(batch, config.paddle_speed, config.step);
+			steps += live;
+			live_steps += live;
+			auto step_before = std::chrono::high_resolution_clock::now();
+			batch.step(config.step);
+			auto step_after = std::chrono::high_resolution_clock::now();
+			step_seconds += std::chrono::duration< double >(step_after - step_before).count();
+			lane_steps += batch.padded;
+			if (config.mode == config.Verify) {
+				reference.input_paddle_y = batch.input_paddle_y;
+				reference.input_serve = batch.input_serve;
+				reference.step_reference(config.step);
+				uint32_t lane = 0;
+				if (!same_games(batch, reference, &lane)) {
+					std::cerr << "ERROR: lane " << lane << " differs from the reference after step " << s << "." << std::endl;
+					return 1;
+				}
+			}
+			for (uint32_t i = 0; i < lanes; ++i) {
+				if (retired[i] || !batch.game_over[i]) continue;
+				if (batch.score[i] == 99) wins += 1;
+				total_score += batch.score[i];
+				if (next_game < config.games) {
+					GameState state = new_game(config.seed, next_game);
+					++next_game;
+					batch.set(i, state);
+					if (config.mode == config.Verify) reference.set(i, state);
+				} else {
+					retired[i] = true;
+					unfinished -= 1;
+				}
+			}
+		}
+		//(games still going when max_steps ran out)
+		for (uint32_t i = 0; i < lanes; ++i) {
+			if (!retired[i]) total_score += batch.score[i];
+		}
+		unfinished += config.games - next_game;
+		std::cout << "GameBatch::step(): " << live_steps << " live game steps in " << step_seconds << "s: "
+		          << live_steps / step_seconds << " live steps/s (" << lane_steps / step_seconds
+		          << " lane-steps/s counting padding and finished lanes)." << std::endl;
+		if (config.mode == config.Verify) {
+			std::cout << "GameBatch matched the reference for every game and step." << std::endl;
+		}
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration< double >(after - before).count();
+
+	std::cout << config.games << " games, " << wins << " won, " << unfinished << " unfinished, mean score "
+	          << (config.games ? double(total_score) / config.games : 0.0) << "." << std::endl;
+	if (config.mode == config.Events) {
+		std::cout << contacts << " contacts in " << seconds << "s: " << seconds * 1e6 / std::max(config.games, 1u) << "us per game." << std::endl;
+	} else {
+		std::cout << steps << " steps of " << config.step << "s (" << steps * config.step / 3600.0 << " game hours) in "
+		          << seconds << "s: " << steps / seconds << " steps/s." << std::endl;
+	}
+
+	return 0;
+}